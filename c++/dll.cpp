@@ -9,12 +9,268 @@
 
 #include <iostream>
 #include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <map>
+#include <mutex>
 #include <stdexcept>
+#include <system_error>
+
+#include <unistd.h>
 
 #include "dll.h"
+#include "dll_trace.h"
 
 static std::string listStr{""};
 
+// How many nodes ahead full-list walks prefetch. Tunable at build time with
+// -DDLL_PREFETCH_DISTANCE=N, 0 disables prefetching.
+#ifndef DLL_PREFETCH_DISTANCE
+#define DLL_PREFETCH_DISTANCE 4
+#endif
+
+namespace
+{
+    // Second cursor running DLL_PREFETCH_DISTANCE nodes ahead of a walk along
+    // `link` (next or prev), so that the cache misses of upcoming nodes
+    // overlap with the work done on the current one. step() must be called
+    // once per visited node, before that node is freed.
+    template <typename NodeT>
+    class Prefetcher
+    {
+        public:
+            Prefetcher(NodeT* first, NodeT* _end, NodeT* NodeT::* _link) :
+                ahead{first},
+                end{_end},
+                link{_link}
+            {
+                for (int i = 0; i < DLL_PREFETCH_DISTANCE and ahead != end; ++i)
+                {
+                    ahead = ahead->*link;
+                    __builtin_prefetch(ahead);
+                }
+            }
+            void step()
+            {
+                if (DLL_PREFETCH_DISTANCE > 0 and ahead != end)
+                {
+                    ahead = ahead->*link;
+                    __builtin_prefetch(ahead);
+                }
+            }
+
+        private:
+            NodeT* ahead;
+            NodeT* end;
+            NodeT* NodeT::* link;
+    };
+
+    // Journal encoding: LEB128 varints, with values zigzag-mapped first so
+    // that small negative numbers stay short too
+    std::uint64_t zigzag(int value)
+    {
+        const std::int64_t wide = value;
+        return (static_cast<std::uint64_t>(wide) << 1) ^ static_cast<std::uint64_t>(wide >> 63);
+    }
+
+    int unzigzag(std::uint64_t raw)
+    {
+        return static_cast<int>(static_cast<std::int64_t>(raw >> 1) ^ -static_cast<std::int64_t>(raw & 1));
+    }
+
+    void putVarint(std::string & out, std::uint64_t raw)
+    {
+        while (raw >= 0x80)
+        {
+            out.push_back(static_cast<char>(raw | 0x80));
+            raw >>= 7;
+        }
+        out.push_back(static_cast<char>(raw));
+    }
+
+    std::uint64_t getVarint(const std::string & in, std::size_t & at)
+    {
+        std::uint64_t raw = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (at == in.size())
+                throw std::invalid_argument("Error: truncated journal");
+            const auto byte = static_cast<unsigned char>(in[at++]);
+            raw |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return raw;
+        }
+        throw std::invalid_argument("Error: malformed journal");
+    }
+
+    constexpr std::size_t registryShards = 16;
+
+    // Shards are dealt to threads in turn, on their first list
+    std::size_t threadRegistryShard()
+    {
+        static std::atomic<std::size_t> threads{0};
+        thread_local const std::size_t shard =
+            threads.fetch_add(1, std::memory_order_relaxed) % registryShards;
+        return shard;
+    }
+
+    // Bytes malloc() really takes to serve `size` bytes, 0 if unknown. glibc
+    // adds a size word and rounds chunks up to 2 words, 4 at least.
+    std::size_t mallocFootprint(std::size_t size)
+    {
+#ifdef __GLIBC__
+        constexpr std::size_t word = sizeof(std::size_t);
+        const std::size_t chunk = (size + word + 2 * word - 1) / (2 * word) * (2 * word);
+        return std::max(chunk, 4 * word);
+#else
+        (void)size;
+        return 0;
+#endif
+    }
+
+    // What tracing records of each operation (see dll_trace.h)
+    constexpr DllTrace::Op traceAt{"at", "pos", nullptr};
+    constexpr DllTrace::Op traceInsertAt{"insertAt", "pos", nullptr};
+    constexpr DllTrace::Op traceAppend{"append", nullptr, nullptr};
+    constexpr DllTrace::Op tracePrepend{"prepend", nullptr, nullptr};
+    constexpr DllTrace::Op traceRemoveAt{"removeAt", "pos", nullptr};
+    constexpr DllTrace::Op traceRemoveFirst{"removeFirst", nullptr, nullptr};
+    constexpr DllTrace::Op traceRemoveLast{"removeLast", nullptr, nullptr};
+    constexpr DllTrace::Op traceClear{"clear", nullptr, nullptr};
+    constexpr DllTrace::Op traceSwap{"swap", "pos1", "pos2"};
+    constexpr DllTrace::Op traceSetAt{"setAt", "pos", nullptr};
+    constexpr DllTrace::Op traceCompact{"compact", nullptr, nullptr};
+    constexpr DllTrace::Op traceMerge{"merge", "rhsSize", nullptr};
+    constexpr DllTrace::Op traceInsertBefore{"insertBefore", nullptr, nullptr};
+    constexpr DllTrace::Op traceInsertAfter{"insertAfter", nullptr, nullptr};
+    constexpr DllTrace::Op traceErase{"erase", nullptr, nullptr};
+    constexpr DllTrace::Op traceMoveToFront{"moveToFront", nullptr, nullptr};
+    constexpr DllTrace::Op traceMoveToBack{"moveToBack", nullptr, nullptr};
+
+    // Incremental parser of the toString() format. feed() may stop early,
+    // before a number running up to the end of its input: the caller passes
+    // those bytes again, followed by more input, on the next call.
+    class ListParser
+    {
+        public:
+            // Parses [first, end) into values, returns the bytes consumed
+            std::size_t feed(const char* first, const char* end, bool last,
+                    std::vector<int> & values)
+            {
+                const char* p = first;
+                for (;;)
+                {
+                    while (p != end and (*p == ' ' or *p == '\t' or *p == '\n' or *p == '\r'))
+                        ++p;
+                    if (p == end)
+                        break;
+                    switch (state)
+                    {
+                        case State::Open:
+                            expect(*p == '[', first, p, "'['");
+                            state = State::FirstValue;
+                            ++p;
+                            break;
+                        case State::FirstValue:
+                            if (*p == ']')
+                            {
+                                state = State::Done;
+                                ++p;
+                                break;
+                            }
+                            [[fallthrough]];
+                        case State::Value:
+                        {
+                            int value;
+                            const auto [next, ec] = std::from_chars(p, end, value);
+                            // The number (or a lone '-') may go on in the next chunk
+                            if ((next == end or (ec != std::errc() and p + 1 == end)) and not last)
+                                return consumed(first, p);
+                            if (ec == std::errc::result_out_of_range)
+                                fail(first, p, "value out of range");
+                            expect(ec == std::errc(), first, p, "a number");
+                            values.push_back(value);
+                            state = State::Separator;
+                            p = next;
+                            break;
+                        }
+                        case State::Separator:
+                            expect(*p == ',' or *p == ']', first, p, "',' or ']'");
+                            state = *p == ',' ? State::Value : State::Done;
+                            ++p;
+                            break;
+                        case State::Done:
+                            fail(first, p, "trailing characters");
+                    }
+                }
+                if (last and state != State::Done)
+                    fail(first, p, "unexpected end of input");
+                return consumed(first, p);
+            }
+
+        private:
+            enum class State { Open, FirstValue, Value, Separator, Done };
+
+            std::size_t consumed(const char* first, const char* p)
+            {
+                offset += p - first;
+                return p - first;
+            }
+            void expect(bool ok, const char* first, const char* p, const char* what)
+            {
+                if (not ok)
+                    fail(first, p, (std::string("expected ") + what).c_str());
+            }
+            [[noreturn]] void fail(const char* first, const char* p, const char* why)
+            {
+                throw std::invalid_argument("Error: malformed list at offset " +
+                        std::to_string(offset + (p - first)) + ": " + why);
+            }
+
+            State state{State::Open};
+            // Bytes consumed by previous calls
+            std::size_t offset{0};
+    };
+}
+
+// Running aggregates: the sum is updated in O(1) and a histogram of the
+// values keeps min and max at its two ends.
+struct DoublyLinkedList::Augment
+{
+    long long sum{0};
+    std::map<int, dllcnt_t> histogram;
+};
+
+// One opcode byte per record, followed by its varint operands
+enum class DoublyLinkedList::JournalOp : std::uint8_t
+{
+    Append = 1,     // value
+    Prepend,        // value
+    Insert,         // position, value
+    Remove,         // position
+    RemoveLast,
+    Swap,           // position, position
+    Set,            // position, value
+    Clear,
+    Snapshot        // count, values...
+};
+
+struct DoublyLinkedList::Journal
+{
+    std::string log;
+    // The log does not describe every change (it was never shipped, dropped
+    // for being bigger than a snapshot, or bypassed): ship a snapshot next
+    bool resync{true};
+};
+
+// Aligned so that two shards' locks never share a cache line
+struct alignas(64) DoublyLinkedList::RegistryShard
+{
+    std::mutex lock;
+    Registry lists;
+};
+
 DoublyLinkedList::Node::Node() :
     next{nullptr},
     prev{nullptr},
@@ -27,6 +283,7 @@ DoublyLinkedList::Node & DoublyLinkedList::Node::operator=(const Node & rhs)
     next = rhs.next;
     prev = rhs.prev;
     value = rhs.value;
+    return *this;
 }
 
 DoublyLinkedList::Node::Node(int _value, Node* _next, Node* _prev) :
@@ -54,20 +311,28 @@ DoublyLinkedList::DoublyLinkedList() :
     // Make head and tail's next and prev point to each other
     head->next = tail;
     tail->prev = head;
+    registryShard = threadRegistryShard();
+    RegistryShard & shard = registry(registryShard);
+    std::lock_guard<std::mutex> guard{shard.lock};
+    shard.lists.append(*this);
 }
 
 DoublyLinkedList::DoublyLinkedList(const DoublyLinkedList & rhs) :
     DoublyLinkedList()
 {
     Node *nd = head;
-    for (DoublyLinkedListIterator it = rhs.begin(); it != rhs.end(); ++it)
+    Prefetcher prefetcher{rhs.head->next, rhs.tail, &Node::next};
+    for (Node *current = rhs.head->next; current != rhs.tail; current = current->next)
     {
-        nd->next = new Node(*it, tail, nd);
+        prefetcher.step();
+        nd->next = new Node(current->value, tail, nd);
         nd = nd->next;
         ++n;
-        // No need to add n count since the count is done when calling
-        // the DoublyLinkedList(const DoublyLinkedList & rhs) constructor ... 
     }
+    tail->prev = nd;
+    if (rhs.augment)
+        augment = std::make_unique<Augment>(*rhs.augment);
+    accounted();
 }
 
 DoublyLinkedList::DoublyLinkedList(DoublyLinkedList && rhs) :
@@ -76,10 +341,38 @@ DoublyLinkedList::DoublyLinkedList(DoublyLinkedList && rhs) :
     std::swap(head, rhs.head);
     std::swap(tail, rhs.tail);
     std::swap(n, rhs.n);
+    std::swap(augment, rhs.augment);
+    std::swap(slabs, rhs.slabs);
+    std::swap(slabNodes, rhs.slabNodes);
+    std::swap(slabLive, rhs.slabLive);
+    std::swap(journal, rhs.journal);
+    std::swap(auxiliaryBytes, rhs.auxiliaryBytes);
+}
+
+DoublyLinkedList & DoublyLinkedList::operator=(DoublyLinkedList && rhs)
+{
+    // Our old nodes are released by rhs
+    std::swap(head, rhs.head);
+    std::swap(tail, rhs.tail);
+    std::swap(n, rhs.n);
+    std::swap(augment, rhs.augment);
+    std::swap(slabs, rhs.slabs);
+    std::swap(slabNodes, rhs.slabNodes);
+    std::swap(slabLive, rhs.slabLive);
+    // The journal stays with this list, which now has a whole new content
+    journalResync();
+    accounted();
+    rhs.accounted();
+    return *this;
 }
 
 DoublyLinkedList::~DoublyLinkedList()
 {
+    {
+        RegistryShard & shard = registry(registryShard);
+        std::lock_guard<std::mutex> guard{shard.lock};
+        shard.lists.remove(*this);
+    }
     clear();
     delete head;
     delete tail;
@@ -92,11 +385,21 @@ DoublyLinkedList& DoublyLinkedList::operator=(const DoublyLinkedList & rhs)
     {
         clear();
         Node *nd = head;
-        for (DoublyLinkedListIterator it = rhs.begin(); it != rhs.end(); ++it)
+        Prefetcher prefetcher{rhs.head->next, rhs.tail, &Node::next};
+        for (Node *current = rhs.head->next; current != rhs.tail; current = current->next)
         {
-            nd->next = new Node(*it, tail, nd);
+            prefetcher.step();
+            nd->next = new Node(current->value, tail, nd);
             nd = nd->next;
+            ++n;
         }
+        tail->prev = nd;
+        if (rhs.augment)
+            augment = std::make_unique<Augment>(*rhs.augment);
+        else
+            augment.reset();
+        journalResync();
+        accounted();
     }
     return *this;
 }
@@ -116,10 +419,13 @@ DoublyLinkedList & DoublyLinkedList::operator/(const DoublyLinkedList & rhs)
     dllcnt_t index{0};
     while (current != tail)
     {
+        removed(current->value);
         current->value /= rhs.at(index);
+        added(current->value);
         current = current->next;
         ++index;
     }
+    journalResync();
     return *this;
 }
 
@@ -133,7 +439,7 @@ dllcnt_t DoublyLinkedList::size() const
     return n;
 }
 
-bool DoublyLinkedList::fromEnd(dllcnt_t pos)
+bool DoublyLinkedList::fromEnd(dllcnt_t pos) const
 {
     if (n > 2)
     {
@@ -147,15 +453,17 @@ bool DoublyLinkedList::fromEnd(dllcnt_t pos)
     return false;
 }
 
-void DoublyLinkedList::insertAt(int value, dllcnt_t pos)
+DoublyLinkedList::iterator DoublyLinkedList::insertAt(int value, dllcnt_t pos)
 {
+    DllTrace::Scope trace{traceInsertAt, this, n, pos};
     // Check range
-    if (pos < 0 or pos > n - 1)
+    if (pos >= n)
         throw std::out_of_range("Error: index out of range");
 
 // Be smart: if pos is closer to the start or end, start looping from that part 
 
-
+    // Before linking: a compaction would move the node we return
+    mutated();
     Node *nd, *current;
     // Insert new node
     if (!fromEnd(pos))
@@ -194,12 +502,15 @@ void DoublyLinkedList::insertAt(int value, dllcnt_t pos)
     }
     // Add up count
     ++n;
+    added(value);
+    journaled(JournalOp::Insert, pos, zigzag(value));
+    return iterator(nd);
 }
 
 void DoublyLinkedList::insertListAt(const DoublyLinkedList & list,
         dllcnt_t pos) 
 {
-    if (pos < 0 or pos > n - 1)
+    if (pos >= n)
         throw std::out_of_range("Error: index out of range");
 
     for (auto item : list)
@@ -208,8 +519,10 @@ void DoublyLinkedList::insertListAt(const DoublyLinkedList & list,
     }
 }
 
-void DoublyLinkedList::append(int value)
+DoublyLinkedList::iterator DoublyLinkedList::append(int value)
 {
+    DllTrace::Scope trace{traceAppend, this, n};
+    mutated();
     // When appending, our new node will always sit between tail's prev and tail
     Node *nd = new Node(value, tail, tail->prev);
     // And make next and prev nodes point to 'n'
@@ -217,44 +530,61 @@ void DoublyLinkedList::append(int value)
     tail->prev = nd;
     // Add up count
     ++n;
+    added(value);
+    journaled(JournalOp::Append, zigzag(value));
+    return iterator(nd);
 }
-void DoublyLinkedList::prepend(int value)
+DoublyLinkedList::iterator DoublyLinkedList::prepend(int value)
 {
+    DllTrace::Scope trace{tracePrepend, this, n};
+    mutated();
     Node *nd = new Node(value, head->next, head);
     // Reorder ptrs
     head->next->prev = nd;
     head->next = nd;
     // Add up count
     ++n;
+    added(value);
+    journaled(JournalOp::Prepend, zigzag(value));
+    return iterator(nd);
 }
 void DoublyLinkedList::removeLast()
 {
+    DllTrace::Scope trace{traceRemoveLast, this, n};
     if (n == 0)
         throw std::out_of_range("Error: list empty");
 
     Node *last = tail->prev;
     last->prev->next = tail;
     tail->prev = last->prev;
-    delete last;
+    removed(last->value);
+    destroy(last);
     // Decrease count
     --n;
+    mutated();
+    journaled(JournalOp::RemoveLast);
 }
 void DoublyLinkedList::removeFirst()
 {
+    DllTrace::Scope trace{traceRemoveFirst, this, n};
     if (n == 0)
         throw std::out_of_range("Error: list empty");
 
     Node *first = head->next;
     first->next->prev = head;
     head->next = first->next;
-    delete first;
+    removed(first->value);
+    destroy(first);
     // Decrease count
     --n;
+    mutated();
+    journaled(JournalOp::Remove, 0);
 }
 
 void DoublyLinkedList::removeAt(dllcnt_t pos)
 {
-    if (n == 0 or (pos < 0 or pos > n - 1))
+    DllTrace::Scope trace{traceRemoveAt, this, n, pos};
+    if (pos >= n)
         throw std::out_of_range("Error: index out of range");
 
     // Idea: start looping from end / start depending on pos
@@ -269,8 +599,9 @@ void DoublyLinkedList::removeAt(dllcnt_t pos)
             deleteNode = current;
             deleteNode->prev->next = deleteNode->next;
             deleteNode->next->prev = deleteNode->prev;
+            removed(deleteNode->value);
             // Delete it
-            delete deleteNode;
+            destroy(deleteNode);
             break;
         }
         current = current->next;
@@ -278,14 +609,128 @@ void DoublyLinkedList::removeAt(dllcnt_t pos)
     }
     // Decrease count
     --n;
+    mutated();
+    journaled(JournalOp::Remove, pos);
 }
+DoublyLinkedList::Node* DoublyLinkedList::handleNode(const_iterator pos,
+        bool endAllowed) const
+{
+    // Sentinels are the only nodes with a null link
+    Node* nd = const_cast<Node*>(pos.current);
+    if (nd == nullptr or nd->prev == nullptr or (nd->next == nullptr and not endAllowed))
+        throw std::invalid_argument("Error: invalid handle");
+    return nd;
+}
+
+DoublyLinkedList::Node* DoublyLinkedList::link(Node* next, int value)
+{
+    Node *nd = new Node(value, next, next->prev);
+    next->prev->next = nd;
+    next->prev = nd;
+    ++n;
+    added(value);
+    mutated();
+    if (journal)
+    {
+        const dllcnt_t pos = positionOf(nd);
+        if (pos == n - 1)
+            journalRecord(JournalOp::Append, zigzag(value), 0);
+        else
+            journalRecord(JournalOp::Insert, pos, zigzag(value));
+    }
+    return nd;
+}
+
+void DoublyLinkedList::unlink(Node* nd)
+{
+    nd->prev->next = nd->next;
+    nd->next->prev = nd->prev;
+}
+
+dllcnt_t DoublyLinkedList::positionOf(const Node* nd) const
+{
+    dllcnt_t pos = 0;
+    for (const Node* current = head->next; current != nd; current = current->next)
+    {
+        ++pos;
+    }
+    return pos;
+}
+
+DoublyLinkedList::iterator DoublyLinkedList::insertBefore(const_iterator pos, int value)
+{
+    DllTrace::Scope trace{traceInsertBefore, this, n};
+    return iterator(link(handleNode(pos, true), value));
+}
+
+DoublyLinkedList::iterator DoublyLinkedList::insertAfter(const_iterator pos, int value)
+{
+    DllTrace::Scope trace{traceInsertAfter, this, n};
+    return iterator(link(handleNode(pos)->next, value));
+}
+
+DoublyLinkedList::iterator DoublyLinkedList::erase(const_iterator pos)
+{
+    DllTrace::Scope trace{traceErase, this, n};
+    Node* nd = handleNode(pos);
+    Node* next = nd->next;
+    if (journal)
+        journalRecord(JournalOp::Remove, positionOf(nd), 0);
+    unlink(nd);
+    removed(nd->value);
+    destroy(nd);
+    --n;
+    mutated();
+    return iterator(next);
+}
+
+void DoublyLinkedList::moveToFront(const_iterator pos)
+{
+    DllTrace::Scope trace{traceMoveToFront, this, n};
+    Node* nd = handleNode(pos);
+    if (nd == head->next)
+        return;
+    if (journal)
+    {
+        journalRecord(JournalOp::Remove, positionOf(nd), 0);
+        journalRecord(JournalOp::Prepend, zigzag(nd->value), 0);
+    }
+    unlink(nd);
+    nd->prev = head;
+    nd->next = head->next;
+    head->next->prev = nd;
+    head->next = nd;
+    mutated();
+}
+
+void DoublyLinkedList::moveToBack(const_iterator pos)
+{
+    DllTrace::Scope trace{traceMoveToBack, this, n};
+    Node* nd = handleNode(pos);
+    if (nd == tail->prev)
+        return;
+    if (journal)
+    {
+        journalRecord(JournalOp::Remove, positionOf(nd), 0);
+        journalRecord(JournalOp::Append, zigzag(nd->value), 0);
+    }
+    unlink(nd);
+    nd->next = tail;
+    nd->prev = tail->prev;
+    tail->prev->next = nd;
+    tail->prev = nd;
+    mutated();
+}
+
 std::string const & DoublyLinkedList::toString() const 
 {
     Node *current = head->next;
+    Prefetcher prefetcher{current, tail, &Node::next};
     listStr.clear();
     listStr += "[";
     while (current != tail)
     {
+        prefetcher.step();
         listStr += std::to_string(current->value);
         if (current->next != tail)
             listStr += ",";
@@ -298,10 +743,12 @@ std::string const & DoublyLinkedList::toString() const
 std::string const & DoublyLinkedList::toReverseString() const
 {
     Node *current = tail->prev;
+    Prefetcher prefetcher{current, head, &Node::prev};
     listStr.clear();
     listStr += "[";
     while (current != head)
     {
+        prefetcher.step();
         listStr += std::to_string(current->value);
         if (current->prev != head)
             listStr += ",";
@@ -341,26 +788,37 @@ void DoublyLinkedList::reversePrint()
 
 void DoublyLinkedList::clear()
 {
+    DllTrace::Scope trace{traceClear, this, n};
     Node *current = head->next;
+    Prefetcher prefetcher{current, tail, &Node::next};
     while (current != tail)
     {
+        prefetcher.step();
         Node *current_cpy = current;
         current = current->next;
-        delete current_cpy;
+        destroy(current_cpy);
         --n;
     }
     head->next = tail;
     tail->prev = head;
+    augmentReset();
+    slabs.clear();
+    slabNodes = 0;
+    slabLive = 0;
+    churn = 0;
+    journaled(JournalOp::Clear);
+    accounted();
 }
 
 // Must-have: at()
 int DoublyLinkedList::at(dllcnt_t pos) const
 {
+    DllTrace::Scope trace{traceAt, this, n, pos};
     // Check range
-    if (pos < 0 or pos > n - 1)
+    if (pos >= n)
         throw std::out_of_range("Error: index out of range");
     auto it = begin();
-    for (int i = 0; i < pos; ++i)
+    for (dllcnt_t i = 0; i < pos; ++i)
     {
         it++;
     }
@@ -371,92 +829,24 @@ int DoublyLinkedList::at(dllcnt_t pos) const
 void DoublyLinkedList::reverseClear()
 {
     Node *current = tail->prev;
+    Prefetcher prefetcher{current, head, &Node::prev};
     while (current != head)
     {
+        prefetcher.step();
         Node *current_cpy = current;
         current = current->prev;
-        delete current_cpy;
+        destroy(current_cpy);
         --n;
     }
     tail->prev = head;
     head->next = tail;
-}
-
-// Own-defined iterator class
-DoublyLinkedList::DoublyLinkedListIterator::DoublyLinkedListIterator(Node*
-node) : 
-    current{node}
-{
-}
-
-bool DoublyLinkedList::DoublyLinkedListIterator::operator==(const
-DoublyLinkedListIterator & rhs) const 
-{
-    return current == rhs.current;
-}
-
-bool DoublyLinkedList::DoublyLinkedListIterator::operator!=(const
-DoublyLinkedListIterator & rhs) const 
-{
-    return !(*this == rhs.current);
-}
-
-int DoublyLinkedList::DoublyLinkedListIterator::operator*() const
-{
-    if (current->next == nullptr)
-        throw std::invalid_argument("Invalid dereference of end() iterator");
-    return current->value;
-}
-
-DoublyLinkedList::DoublyLinkedListIterator &
-DoublyLinkedList::DoublyLinkedListIterator::operator++() 
-{
-    current->next != nullptr ?
-        current = current->next :
-        throw std::invalid_argument("Invalid iterator index");
-    return *this;
-}
-
-DoublyLinkedList::DoublyLinkedListIterator &
-DoublyLinkedList::DoublyLinkedListIterator::operator++(int) 
-{
-    // We will return the iterator BEFORE incrementing its value
-    DoublyLinkedListIterator iter = *this;
-    current->next != nullptr ?
-        current = current->next :
-        throw std::invalid_argument("Invalid iterator index");
-    return iter;
-}
-
-DoublyLinkedList::DoublyLinkedListIterator &
-DoublyLinkedList::DoublyLinkedListIterator::operator--() 
-{
-    current->prev != nullptr ?
-        current = current->prev :
-        throw std::invalid_argument("Invalid iterator index");
-    return *this;
-}
-
-DoublyLinkedList::DoublyLinkedListIterator &
-DoublyLinkedList::DoublyLinkedListIterator::operator--(int) 
-{
-    // We will return the iterator BEFORE incrementing its value
-    DoublyLinkedListIterator iter = *this;
-    current->prev != nullptr ?
-        current = current->prev :
-        throw std::invalid_argument("Invalid iterator index");
-    return iter;
-}
-
-DoublyLinkedList::DoublyLinkedListIterator const DoublyLinkedList::begin()
-const 
-{
-    return DoublyLinkedListIterator(head->next);
-}
-
-DoublyLinkedList::DoublyLinkedListIterator const DoublyLinkedList::end() const
-{
-    return DoublyLinkedListIterator(tail);
+    augmentReset();
+    slabs.clear();
+    slabNodes = 0;
+    slabLive = 0;
+    churn = 0;
+    journaled(JournalOp::Clear);
+    accounted();
 }
 
 /*
@@ -468,9 +858,10 @@ DoublyLinkedList::DoublyLinkedListIterator const DoublyLinkedList::end() const
  */
 void DoublyLinkedList::swap(dllcnt_t pos1, dllcnt_t pos2)
 {
+    DllTrace::Scope trace{traceSwap, this, n, pos1, pos2};
     // Range checks
-    if ((pos1 < 0 or pos1 > n - 1) or // Pos1 invalid
-            (pos2 < 0 or pos2 > n - 1) or // Pos2 invalid
+    if ((pos1 >= n) or // Pos1 invalid
+            (pos2 >= n) or // Pos2 invalid
             (pos1 == pos2)) // Same pos
         throw std::out_of_range("Invalid range");
 
@@ -494,12 +885,14 @@ void DoublyLinkedList::swap(dllcnt_t pos1, dllcnt_t pos2)
     second_next->prev = first;
     first->prev = second_prev;
     second_prev->next = first;
+    mutated();
+    journaled(JournalOp::Swap, pos1, pos2);
 }
 
-DoublyLinkedList::Node* DoublyLinkedList::nodeAt(dllcnt_t pos)
+DoublyLinkedList::Node* DoublyLinkedList::nodeAt(dllcnt_t pos) const
 {
     // Check range
-    if (pos < 0 or pos > n - 1)
+    if (pos >= n)
         throw std::out_of_range("ERROR: out of index");
 
     Node *target;
@@ -508,30 +901,733 @@ DoublyLinkedList::Node* DoublyLinkedList::nodeAt(dllcnt_t pos)
     if (!fromEnd(pos))
     {
         cnt = 0;
-        auto it = begin();
-        while (it != end() and cnt != pos)
+        target = head->next;
+        while (cnt != pos)
         {
-            ++it;
+            target = target->next;
             ++cnt;
         }
-        target = it.current;
     }
     else
     {
         cnt = n - 1;
-        // end() is tail, so we want the previous one
-        DoublyLinkedListIterator iter = end();
-        auto it = --iter;
-        while (it != head and cnt != pos)
+        // tail is a sentinel, so we want the previous one
+        target = tail->prev;
+        while (cnt != pos)
         {
-            --it;
+            target = target->prev;
             --cnt;
         }
-        target = it.current;
     }
     return target;
 }
 
+void DoublyLinkedList::setAt(dllcnt_t pos, int value)
+{
+    DllTrace::Scope trace{traceSetAt, this, n, pos};
+    Node *nd = nodeAt(pos);
+    removed(nd->value);
+    nd->value = value;
+    added(value);
+    journaled(JournalOp::Set, pos, zigzag(value));
+}
+
+void DoublyLinkedList::augmentAdd(int value)
+{
+    augment->sum += value;
+    if (++augment->histogram[value] == 1)
+        accounted();
+}
+
+void DoublyLinkedList::augmentRemove(int value)
+{
+    augment->sum -= value;
+    auto entry = augment->histogram.find(value);
+    if (--entry->second == 0)
+    {
+        augment->histogram.erase(entry);
+        accounted();
+    }
+}
+
+void DoublyLinkedList::augmentReset()
+{
+    if (augment)
+        *augment = Augment{};
+    accounted();
+}
+
+void DoublyLinkedList::enableAggregates()
+{
+    if (!augment)
+        refreshAggregates();
+    accounted();
+}
+
+void DoublyLinkedList::disableAggregates()
+{
+    augment.reset();
+    accounted();
+}
+
+bool DoublyLinkedList::aggregatesEnabled() const
+{
+    return static_cast<bool>(augment);
+}
+
+void DoublyLinkedList::refreshAggregates()
+{
+    augment = std::make_unique<Augment>();
+    for (int value : *this)
+    {
+        augmentAdd(value);
+    }
+}
+
+long long DoublyLinkedList::sum() const
+{
+    return aggregates().sum;
+}
+
+int DoublyLinkedList::min() const
+{
+    return aggregates().min;
+}
+
+int DoublyLinkedList::max() const
+{
+    return aggregates().max;
+}
+
+// O(1) when the aggregates are enabled, a full walk otherwise
+DoublyLinkedList::Aggregates DoublyLinkedList::aggregates() const
+{
+    if (n == 0)
+        throw std::out_of_range("Error: list empty");
+    if (!augment)
+        return aggregates(0, n - 1);
+    return Aggregates{augment->sum, augment->histogram.begin()->first,
+        augment->histogram.rbegin()->first, n};
+}
+
+DoublyLinkedList::Aggregates DoublyLinkedList::aggregates(dllcnt_t first,
+        dllcnt_t last) const
+{
+    if (first > last)
+        throw std::out_of_range("Error: invalid range");
+    // nodeAt() does the range checks
+    Node *current = nodeAt(first);
+    Node *stop = nodeAt(last)->next;
+    Aggregates result{0, current->value, current->value, last - first + 1};
+    while (current != stop)
+    {
+        result.sum += current->value;
+        result.min = std::min(result.min, current->value);
+        result.max = std::max(result.max, current->value);
+        current = current->next;
+    }
+    return result;
+}
+
+void DoublyLinkedList::compact()
+{
+    DllTrace::Scope trace{traceCompact, this, n};
+    if (n == 0)
+    {
+        clear();
+        return;
+    }
+
+    // One block for all nodes; values are copied over in list order
+    std::unique_ptr<Node[]> slab{new Node[n]};
+    Node *prev = head;
+    Node *current = head->next;
+    Prefetcher prefetcher{current, tail, &Node::next};
+    for (dllcnt_t i = 0; i < n; ++i)
+    {
+        prefetcher.step();
+        Node *nd = &slab[i];
+        Node *next = current->next;
+        nd->value = current->value;
+        nd->inSlab = true;
+        nd->prev = prev;
+        prev->next = nd;
+        destroy(current);
+        prev = nd;
+        current = next;
+    }
+    prev->next = tail;
+    tail->prev = prev;
+
+    // Every node of the previous slabs was either moved or already removed
+    slabs.clear();
+    slabs.push_back(std::move(slab));
+    slabNodes = n;
+    slabLive = n;
+    churn = 0;
+    accounted();
+}
+
+double DoublyLinkedList::fragmentation() const
+{
+    if (n < 2)
+        return 0.0;
+
+    // Two nodes are adjacent when the next one starts within a cache line of
+    // the end of the current one (allocator headers included)
+    constexpr std::ptrdiff_t nearby = sizeof(Node) + 64;
+    dllcnt_t scattered = 0;
+    Node *current = head->next;
+    while (current->next != tail)
+    {
+        const std::ptrdiff_t distance = reinterpret_cast<const char*>(current->next) -
+            reinterpret_cast<const char*>(current);
+        if (distance <= 0 or distance > nearby)
+            ++scattered;
+        current = current->next;
+    }
+    return static_cast<double>(scattered) / static_cast<double>(n - 1);
+}
+
+void DoublyLinkedList::setAutoCompact(double threshold)
+{
+    autoCompactThreshold = threshold;
+    churn = 0;
+}
+
+bool DoublyLinkedList::maybeCompact()
+{
+    if (autoCompactThreshold <= 0.0 or churn <= n / 4)
+        return false;
+    churn = 0;
+    if (fragmentation() <= autoCompactThreshold)
+        return false;
+    compact();
+    return true;
+}
+
+void DoublyLinkedList::journalRecord(JournalOp op, std::uint64_t first,
+        std::uint64_t second)
+{
+    // Nothing before a clear matters to a replica anymore
+    if (op == JournalOp::Clear)
+    {
+        journal->log.clear();
+        journal->resync = false;
+    }
+    else if (journal->resync)
+    {
+        return;
+    }
+
+    std::string & log = journal->log;
+    const std::size_t capacity = log.capacity();
+    log.push_back(static_cast<char>(op));
+    switch (op)
+    {
+        case JournalOp::Insert:
+        case JournalOp::Swap:
+        case JournalOp::Set:
+            putVarint(log, first);
+            putVarint(log, second);
+            break;
+        case JournalOp::Append:
+        case JournalOp::Prepend:
+        case JournalOp::Remove:
+            putVarint(log, first);
+            break;
+        default:
+            break;
+    }
+
+    // A snapshot takes at most 5 bytes per value: past that, the log is
+    // dead weight and the next delta will be a snapshot anyway
+    if (log.size() > 5 * n + 16)
+        journalResync();
+    if (log.capacity() != capacity)
+        accounted();
+}
+
+void DoublyLinkedList::journalResync()
+{
+    if (journal)
+    {
+        journal->log.clear();
+        journal->resync = true;
+    }
+}
+
+void DoublyLinkedList::enableJournal()
+{
+    if (!journal)
+        journal = std::make_unique<Journal>();
+    accounted();
+}
+
+void DoublyLinkedList::disableJournal()
+{
+    journal.reset();
+    accounted();
+}
+
+bool DoublyLinkedList::journalEnabled() const
+{
+    return static_cast<bool>(journal);
+}
+
+std::string DoublyLinkedList::takeDelta()
+{
+    if (!journal)
+        return snapshot();
+
+    // A snapshot takes at least n + 2 bytes: only encode one when it may win
+    if (journal->resync or journal->log.size() > n + 2)
+    {
+        std::string full = snapshot();
+        if (journal->resync or full.size() < journal->log.size())
+        {
+            journal->log.clear();
+            journal->resync = false;
+            return full;
+        }
+    }
+    std::string delta;
+    delta.swap(journal->log);
+    accounted();
+    return delta;
+}
+
+std::string DoublyLinkedList::snapshot() const
+{
+    std::string out;
+    out.reserve(n + 16);
+    out.push_back(static_cast<char>(JournalOp::Snapshot));
+    putVarint(out, n);
+    Prefetcher prefetcher{head->next, tail, &Node::next};
+    for (Node *current = head->next; current != tail; current = current->next)
+    {
+        prefetcher.step();
+        putVarint(out, zigzag(current->value));
+    }
+    return out;
+}
+
+void DoublyLinkedList::replay(const std::string & delta)
+{
+    std::size_t at = 0;
+    while (at < delta.size())
+    {
+        const auto op = static_cast<JournalOp>(delta[at++]);
+        switch (op)
+        {
+            case JournalOp::Append:
+                append(unzigzag(getVarint(delta, at)));
+                break;
+            case JournalOp::Prepend:
+                prepend(unzigzag(getVarint(delta, at)));
+                break;
+            case JournalOp::Insert:
+            {
+                const dllcnt_t pos = getVarint(delta, at);
+                insertAt(unzigzag(getVarint(delta, at)), pos);
+                break;
+            }
+            case JournalOp::Remove:
+                removeAt(getVarint(delta, at));
+                break;
+            case JournalOp::RemoveLast:
+                removeLast();
+                break;
+            case JournalOp::Swap:
+            {
+                const dllcnt_t pos1 = getVarint(delta, at);
+                swap(pos1, getVarint(delta, at));
+                break;
+            }
+            case JournalOp::Set:
+            {
+                const dllcnt_t pos = getVarint(delta, at);
+                setAt(pos, unzigzag(getVarint(delta, at)));
+                break;
+            }
+            case JournalOp::Clear:
+                clear();
+                break;
+            case JournalOp::Snapshot:
+            {
+                const dllcnt_t count = getVarint(delta, at);
+                // Every value takes at least one byte
+                if (count > delta.size() - at)
+                    throw std::invalid_argument("Error: truncated journal");
+                clear();
+                for (dllcnt_t i = 0; i < count; ++i)
+                {
+                    append(unzigzag(getVarint(delta, at)));
+                }
+                break;
+            }
+            default:
+                throw std::invalid_argument("Error: malformed journal");
+        }
+    }
+}
+
+void DoublyLinkedList::merge(DoublyLinkedList & rhs)
+{
+    DllTrace::Scope trace{traceMerge, this, n, rhs.n};
+    if (&rhs == this or rhs.n == 0)
+        return;
+
+    if (augment)
+    {
+        for (int value : rhs)
+        {
+            augmentAdd(value);
+        }
+    }
+
+    Node *a = head->next;
+    Node *b = rhs.head->next;
+    while (b != rhs.tail)
+    {
+        if (a == tail)
+        {
+            // What is left of rhs goes at the end, in one go
+            b->prev = tail->prev;
+            tail->prev->next = b;
+            rhs.tail->prev->next = tail;
+            tail->prev = rhs.tail->prev;
+            break;
+        }
+        if (b->value < a->value)
+        {
+            Node *next = b->next;
+            b->prev = a->prev;
+            b->next = a;
+            a->prev->next = b;
+            a->prev = b;
+            b = next;
+        }
+        else
+        {
+            a = a->next;
+        }
+    }
+    n += rhs.n;
+
+    // Compacted nodes came along: so does the ownership of their slabs
+    for (auto & slab : rhs.slabs)
+    {
+        slabs.push_back(std::move(slab));
+    }
+    rhs.slabs.clear();
+    slabNodes += rhs.slabNodes;
+    rhs.slabNodes = 0;
+    slabLive += rhs.slabLive;
+    rhs.slabLive = 0;
+    rhs.head->next = rhs.tail;
+    rhs.tail->prev = rhs.head;
+    rhs.n = 0;
+    rhs.churn = 0;
+    rhs.augmentReset();
+    rhs.journaled(JournalOp::Clear);
+    journalResync();
+    accounted();
+}
+
+DoublyLinkedList DoublyLinkedList::setUnion(const DoublyLinkedList & rhs) const
+{
+    DoublyLinkedList result;
+    auto a = begin();
+    auto b = rhs.begin();
+    while (a != end() and b != rhs.end())
+    {
+        if (*a < *b)
+        {
+            result.append(*a++);
+        }
+        else if (*b < *a)
+        {
+            result.append(*b++);
+        }
+        else
+        {
+            result.append(*a++);
+            ++b;
+        }
+    }
+    for (; a != end(); ++a)
+    {
+        result.append(*a);
+    }
+    for (; b != rhs.end(); ++b)
+    {
+        result.append(*b);
+    }
+    return result;
+}
+
+DoublyLinkedList DoublyLinkedList::setIntersection(const DoublyLinkedList & rhs) const
+{
+    DoublyLinkedList result;
+    auto a = begin();
+    auto b = rhs.begin();
+    while (a != end() and b != rhs.end())
+    {
+        if (*a < *b)
+        {
+            ++a;
+        }
+        else if (*b < *a)
+        {
+            ++b;
+        }
+        else
+        {
+            result.append(*a++);
+            ++b;
+        }
+    }
+    return result;
+}
+
+DoublyLinkedList DoublyLinkedList::setDifference(const DoublyLinkedList & rhs) const
+{
+    DoublyLinkedList result;
+    auto a = begin();
+    auto b = rhs.begin();
+    while (a != end() and b != rhs.end())
+    {
+        if (*a < *b)
+        {
+            result.append(*a++);
+        }
+        else if (*b < *a)
+        {
+            ++b;
+        }
+        else
+        {
+            ++a;
+            ++b;
+        }
+    }
+    for (; a != end(); ++a)
+    {
+        result.append(*a);
+    }
+    return result;
+}
+
+bool DoublyLinkedList::includes(const DoublyLinkedList & rhs) const
+{
+    auto a = begin();
+    for (auto b = rhs.begin(); b != rhs.end(); ++a)
+    {
+        // b is smaller than anything left here
+        if (a == end() or *b < *a)
+            return false;
+        if (not (*a < *b))
+            ++b;
+    }
+    return true;
+}
+
+void DoublyLinkedList::appendBulk(const std::vector<int> & values)
+{
+    if (values.empty())
+        return;
+
+    // One allocation for all the nodes, linked in order like compact() does
+    std::unique_ptr<Node[]> slab{new Node[values.size()]};
+    Node *prev = tail->prev;
+    for (std::size_t i = 0; i < values.size(); ++i)
+    {
+        Node *nd = &slab[i];
+        nd->value = values[i];
+        nd->inSlab = true;
+        nd->prev = prev;
+        prev->next = nd;
+        prev = nd;
+        added(values[i]);
+        journaled(JournalOp::Append, zigzag(values[i]));
+    }
+    prev->next = tail;
+    tail->prev = prev;
+    n += values.size();
+    slabs.push_back(std::move(slab));
+    slabNodes += values.size();
+    slabLive += values.size();
+    accounted();
+}
+
+DoublyLinkedList DoublyLinkedList::fromString(std::string_view text)
+{
+    DoublyLinkedList list;
+    std::vector<int> values;
+    ListParser parser;
+    parser.feed(text.data(), text.data() + text.size(), true, values);
+    list.appendBulk(values);
+    return list;
+}
+
+DoublyLinkedList DoublyLinkedList::fromChunks(
+        const std::function<std::size_t(char*, std::size_t)> & read)
+{
+    // Values are flushed to the list one slab at a time
+    constexpr std::size_t chunkBytes = 64 * 1024;
+    constexpr std::size_t chunkNodes = 16 * 1024;
+
+    DoublyLinkedList list;
+    std::vector<int> values;
+    ListParser parser;
+    std::unique_ptr<char[]> buffer{new char[chunkBytes]};
+    std::size_t kept = 0;
+    for (;;)
+    {
+        const std::size_t got = read(buffer.get() + kept, chunkBytes - kept);
+        const bool last = got == 0;
+        const std::size_t available = kept + got;
+        const std::size_t used = parser.feed(buffer.get(), buffer.get() + available, last, values);
+        if (values.size() >= chunkNodes)
+        {
+            list.appendBulk(values);
+            values.clear();
+        }
+        if (last)
+            break;
+        // Carry the start of a number cut by the end of the chunk over
+        kept = available - used;
+        if (kept == chunkBytes)
+            throw std::invalid_argument("Error: malformed list: number too long");
+        std::memmove(buffer.get(), buffer.get() + used, kept);
+    }
+    list.appendBulk(values);
+    return list;
+}
+
+DoublyLinkedList DoublyLinkedList::fromStream(std::istream & in)
+{
+    return fromChunks([&in](char* buffer, std::size_t size) -> std::size_t {
+        in.read(buffer, size);
+        if (in.bad())
+            throw std::ios_base::failure("Error: cannot read the stream");
+        return in.gcount();
+    });
+}
+
+DoublyLinkedList DoublyLinkedList::fromFd(int fd)
+{
+    return fromChunks([fd](char* buffer, std::size_t size) -> std::size_t {
+        for (;;)
+        {
+            const ssize_t got = ::read(fd, buffer, size);
+            if (got >= 0)
+                return got;
+            if (errno != EINTR)
+                throw std::system_error(errno, std::generic_category(), "Error: cannot read the list");
+        }
+    });
+}
+
+DoublyLinkedList::RegistryShard & DoublyLinkedList::registry(std::size_t shard)
+{
+    // Never destroyed: static lists may outlive any other static object
+    static RegistryShard* shards = new RegistryShard[registryShards];
+    return shards[shard];
+}
+
+void DoublyLinkedList::accounted()
+{
+    std::size_t bytes = slabs.capacity() * sizeof(slabs[0]);
+    if (augment)
+    {
+        // libstdc++'s red-black tree nodes: color and 3 links, then the entry
+        bytes += sizeof(Augment) + augment->histogram.size() *
+            (sizeof(std::pair<const int, dllcnt_t>) + 4 * sizeof(void*));
+    }
+    if (journal)
+        bytes += sizeof(Journal) + journal->log.capacity();
+    auxiliaryBytes = bytes;
+}
+
+DoublyLinkedList::MemoryUsage DoublyLinkedList::memoryUsage() const
+{
+    // Each counter is read once. Another thread may be modifying the list
+    // between two reads: clamp what depends on several of them.
+    const dllcnt_t elements = n;
+    const dllcnt_t allSlabNodes = slabNodes;
+    const dllcnt_t inSlabs = std::min<dllcnt_t>(slabLive, std::min(elements, allSlabNodes));
+
+    MemoryUsage usage;
+    usage.elements = elements;
+    usage.payloadBytes = elements * sizeof(int);
+    usage.linkBytes = elements * (sizeof(Node) - sizeof(int));
+    usage.sentinelBytes = 2 * sizeof(Node) + sizeof(DoublyLinkedList);
+    usage.auxiliaryBytes = auxiliaryBytes;
+    usage.slackBytes = (allSlabNodes - inSlabs) * sizeof(Node);
+
+    // Sentinels and heap nodes come from operator new, i.e. malloc
+    const std::size_t footprint = mallocFootprint(sizeof(Node));
+    if (footprint == 0)
+        usage.slackKnown = false;
+    else
+        usage.slackBytes += (2 + elements - inSlabs) * (footprint - sizeof(Node));
+
+    usage.totalBytes = usage.payloadBytes + usage.linkBytes + usage.sentinelBytes +
+        usage.auxiliaryBytes + usage.slackBytes;
+    return usage;
+}
+
+DoublyLinkedList::MemoryUsage DoublyLinkedList::totalMemoryUsage(std::size_t* lists)
+{
+    MemoryUsage total;
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < registryShards; ++i)
+    {
+        RegistryShard & shard = registry(i);
+        std::lock_guard<std::mutex> guard{shard.lock};
+        for (const DoublyLinkedList & list : shard.lists)
+        {
+            const MemoryUsage usage = list.memoryUsage();
+            total.elements += usage.elements;
+            total.payloadBytes += usage.payloadBytes;
+            total.linkBytes += usage.linkBytes;
+            total.sentinelBytes += usage.sentinelBytes;
+            total.auxiliaryBytes += usage.auxiliaryBytes;
+            total.slackBytes += usage.slackBytes;
+            total.slackKnown = total.slackKnown and usage.slackKnown;
+            total.totalBytes += usage.totalBytes;
+        }
+        count += shard.lists.count();
+    }
+    if (lists)
+        *lists = count;
+    return total;
+}
+
+std::istream & operator>>(std::istream & in, DoublyLinkedList & list)
+{
+    std::string text;
+    in >> std::ws;
+    // Running out of input before the ']' fails too
+    if (not std::getline(in, text, ']') or in.eof())
+    {
+        in.setstate(std::ios_base::failbit);
+        return in;
+    }
+    text.push_back(']');
+    try
+    {
+        list = DoublyLinkedList::fromString(text);
+    }
+    catch (const std::invalid_argument &)
+    {
+        in.setstate(std::ios_base::failbit);
+    }
+    return in;
+}
+
 std::ostream & operator<<(std::ostream & out, const DoublyLinkedList & list)
 {
     std::string outlist{list.toString()};
@@ -10,9 +10,59 @@
 #define __DLL_H_
 
 #include <string>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <iterator>
+#include <ranges>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
 #include <initializer_list>
 
-using dllcnt_t = int;
+#include "dll_intrusive.h"
+
+// Sizes and positions: unsigned 64-bit, so lists may grow past 2^31 elements.
+// Being unsigned, a "negative" position wraps around and is simply >= n.
+using dllcnt_t = std::uint64_t;
+
+// Build with -DDLL_DEBUG_ITERATORS to get range-checked iterators
+#ifdef DLL_DEBUG_ITERATORS
+inline constexpr bool dllCheckedIterators = true;
+#else
+inline constexpr bool dllCheckedIterators = false;
+#endif
+
+// A count written by the thread modifying its list, and read by any thread
+// (memory accounting). Loads and stores are relaxed atomics, which compile to
+// plain moves on common hardware: no read-modify-write, so only one thread
+// may write it at a time, as with the rest of the list.
+template <typename T>
+class RelaxedCounter
+{
+    public:
+        RelaxedCounter(T initial = 0) : value{initial} {}
+        RelaxedCounter(const RelaxedCounter & rhs) : value{rhs.load()} {}
+        RelaxedCounter & operator=(const RelaxedCounter & rhs) { return *this = rhs.load(); }
+        RelaxedCounter & operator=(T rhs)
+        {
+            value.store(rhs, std::memory_order_relaxed);
+            return *this;
+        }
+        operator T() const { return load(); }
+        T load() const { return value.load(std::memory_order_relaxed); }
+        RelaxedCounter & operator+=(T delta) { return *this = load() + delta; }
+        RelaxedCounter & operator-=(T delta) { return *this = load() - delta; }
+        RelaxedCounter & operator++() { return *this += 1; }
+        RelaxedCounter & operator--() { return *this -= 1; }
+
+    private:
+        std::atomic<T> value;
+};
 
 class DoublyLinkedList
 {
@@ -40,24 +90,82 @@ class DoublyLinkedList
                 Node* next;
                 Node* prev;
                 int value;
+                // Lives in a compaction slab rather than its own allocation
+                bool inSlab{false};
         };
 
+        // Running aggregates, only allocated when enabled (see dll.cpp)
+        struct Augment;
+
         Node* head;
         Node* tail;
-        dllcnt_t n;
+        RelaxedCounter<dllcnt_t> n;
+        std::unique_ptr<Augment> augment;
+        // Blocks holding compacted nodes, released by clear() and compact()
+        std::vector<std::unique_ptr<Node[]>> slabs;
+        // Nodes in all slabs, whether still in the list or not, and those
+        // still in the list
+        RelaxedCounter<dllcnt_t> slabNodes{0};
+        RelaxedCounter<dllcnt_t> slabLive{0};
+        // Bytes of the slab table, aggregates and journal, as last published
+        // by accounted()
+        RelaxedCounter<std::size_t> auxiliaryBytes{0};
+        double autoCompactThreshold{0.0};
+        dllcnt_t churn{0};
 
     private:
-        DoublyLinkedList::Node* nodeAt(dllcnt_t pos);
-        bool fromEnd(dllcnt_t pos);
+        DoublyLinkedList::Node* nodeAt(dllcnt_t pos) const;
+        bool fromEnd(dllcnt_t pos) const;
+        // Keep the aggregates in sync: only a null check when disabled
+        void added(int value)
+        {
+            if (augment)
+                augmentAdd(value);
+        }
+        void removed(int value)
+        {
+            if (augment)
+                augmentRemove(value);
+        }
+        void augmentAdd(int value);
+        void augmentRemove(int value);
+        void augmentReset();
+        void destroy(Node* nd)
+        {
+            if (nd->inSlab)
+                --slabLive;
+            else
+                delete nd;
+        }
+        // Publish auxiliaryBytes after the slabs, aggregates or journal changed
+        void accounted();
+        // Called by modifiers; only counts, and only when auto-compaction is
+        // enabled. Modifiers never compact themselves: handles must survive
+        // them, so compaction waits for maybeCompact().
+        void mutated()
+        {
+            if (autoCompactThreshold > 0.0)
+                ++churn;
+        }
+        // Replication journal (see dll.cpp): records are only appended when
+        // enabled, so disabled lists pay a null check per modification
+        enum class JournalOp : std::uint8_t;
+        struct Journal;
+        std::unique_ptr<Journal> journal;
+        void journaled(JournalOp op, std::uint64_t first = 0, std::uint64_t second = 0)
+        {
+            if (journal)
+                journalRecord(op, first, second);
+        }
+        void journalRecord(JournalOp op, std::uint64_t first, std::uint64_t second);
+        // Content changed behind the journal's back: next delta is a snapshot
+        void journalResync();
 
     public:
         int at(dllcnt_t pos) const;
         dllcnt_t count() const;
         dllcnt_t size() const;
-        void insertAt(int value, dllcnt_t pos);
         void insertListAt(const DoublyLinkedList & list, dllcnt_t pos);
-        void append(int value);
-        void prepend(int value);
         void removeAt(dllcnt_t pos);
         void removeLast();
         void removeFirst();
@@ -73,29 +181,291 @@ class DoublyLinkedList
         void print();
         void reversePrint();
         void swap(dllcnt_t pos1, dllcnt_t pos2);
+        void setAt(dllcnt_t pos, int value);
+
+    public:
+        // Aggregates. Once enabled they are maintained by every modifier, so
+        // queries are O(1) instead of a walk. Writes done through iterators
+        // bypass them: call refreshAggregates() after such writes.
+        struct Aggregates
+        {
+            long long sum;
+            int min;
+            int max;
+            dllcnt_t count;
+        };
+        void enableAggregates();
+        void disableAggregates();
+        bool aggregatesEnabled() const;
+        void refreshAggregates();
+        long long sum() const;
+        int min() const;
+        int max() const;
+        Aggregates aggregates() const;
+        // Aggregates over positions [first, last], computed with a walk
+        Aggregates aggregates(dllcnt_t first, dllcnt_t last) const;
+
+    public:
+        // Memory locality. compact() moves all nodes into one block, in list
+        // order, so that walks stream through memory again. It invalidates
+        // every iterator into the list.
+        void compact();
+        // Share of links to a node that is not adjacent in memory (0 to 1)
+        double fragmentation() const;
+        // Compact automatically once fragmentation() exceeds threshold. 0
+        // (the default) disables. No modifier moves nodes: compaction only
+        // happens in maybeCompact(), to be called where no handle is held
+        // (between batches, once per tick...). It measures fragmentation
+        // only after n/4 modifications, so calling it often is amortized
+        // O(1). Returns whether it compacted.
+        void setAutoCompact(double threshold);
+        bool maybeCompact();
+
+    public:
+        // Replication. Once the journal is enabled every modifier appends a
+        // compact binary record to a log, and replay() applies such records to
+        // a replica. Writes done through iterators bypass the journal.
+        void enableJournal();
+        void disableJournal();
+        bool journalEnabled() const;
+        // Everything logged since the previous call, or a snapshot when that
+        // is smaller. The first delta after enableJournal() is a snapshot, as
+        // is every delta when the journal is disabled.
+        std::string takeDelta();
+        // Whole content; replaying it replaces the replica's content
+        std::string snapshot() const;
+        // Apply a delta or snapshot, throws std::invalid_argument if malformed
+        void replay(const std::string & delta);
+
+    public:
+        // Sorted lists (ascending order), all in linear time. Repeated values
+        // are handled like multisets, as std::set_union & co. do.
+        // Move every element of rhs in, keeping the order: nodes are relinked,
+        // nothing is allocated. Equal values keep ours first. rhs ends empty.
+        void merge(DoublyLinkedList & rhs);
+        DoublyLinkedList setUnion(const DoublyLinkedList & rhs) const;
+        DoublyLinkedList setIntersection(const DoublyLinkedList & rhs) const;
+        DoublyLinkedList setDifference(const DoublyLinkedList & rhs) const;
+        // Whether every element of rhs is also in this list
+        bool includes(const DoublyLinkedList & rhs) const;
+    public:
+        // Parsing the toString() format back: "[1,-2,3]", blanks allowed
+        // around brackets, commas and numbers. Malformed input throws
+        // std::invalid_argument with the offset of the first bad byte. Nodes
+        // are allocated in bulk, in slabs as compact() does.
+        static DoublyLinkedList fromString(std::string_view text);
+        // Streaming: the input is parsed in fixed-size chunks as it is read,
+        // never held whole. It must be one list, followed by blanks at most.
+        // Read errors throw std::ios_base::failure / std::system_error.
+        static DoublyLinkedList fromStream(std::istream & in);
+        static DoublyLinkedList fromFd(int fd);
+        // Append every value of a range (a view, another list, a container),
+        // nodes allocated in one slab. The range is read whole before the
+        // list changes, so it may be a view of this very list.
+        template <std::ranges::input_range Range>
+        void appendRange(Range && range)
+        {
+            std::vector<int> values;
+            if constexpr (std::ranges::sized_range<Range>)
+                values.reserve(std::ranges::size(range));
+            for (auto && value : range)
+            {
+                values.push_back(value);
+            }
+            appendBulk(values);
+        }
+
+    private:
+        // read(buffer, size) returns the bytes it stored, 0 at the end
+        static DoublyLinkedList fromChunks(
+                const std::function<std::size_t(char*, std::size_t)> & read);
+        void appendBulk(const std::vector<int> & values);
+
     public:
-        // Iterators
-        class DoublyLinkedListIterator :
-            public std::iterator<std::bidirectional_iterator_tag, int>
-    {
-        public:
-            friend DoublyLinkedList;
-            bool operator==(const DoublyLinkedListIterator & rhs) const;
-            bool operator!=(const DoublyLinkedListIterator & rhs) const;
-            DoublyLinkedListIterator & operator++();
-            DoublyLinkedListIterator & operator++(int);
-            DoublyLinkedListIterator & operator--();
-            DoublyLinkedListIterator & operator--(int);
-            int operator*() const;
-        private:
-            DoublyLinkedListIterator(Node*);
-            Node* current;
-    };
-        DoublyLinkedListIterator const begin() const;
-        DoublyLinkedListIterator const end() const;
+        // Memory accounting: what the list owns, in bytes. The slack is the
+        // allocator's headers and rounding (known with glibc's malloc) plus
+        // slab nodes no longer in the list.
+        struct MemoryUsage
+        {
+            dllcnt_t elements{0};
+            std::size_t payloadBytes{0};   // The values
+            std::size_t linkBytes{0};      // Rest of the element nodes
+            std::size_t sentinelBytes{0};  // Head, tail and the list object
+            std::size_t auxiliaryBytes{0}; // Aggregates, journal, slab table
+            std::size_t slackBytes{0};
+            bool slackKnown{true};
+            std::size_t totalBytes{0};
+        };
+        // O(1): read from counters kept up to date by the modifiers
+        MemoryUsage memoryUsage() const;
+        // Sum over every live list of the process. Safe while other threads
+        // modify their lists: only their counters are read, atomically, and
+        // a list being modified meanwhile adds figures from just before or
+        // after each change.
+        static MemoryUsage totalMemoryUsage(std::size_t* lists = nullptr);
+
+    private:
+        // Every live list is linked into a shard of the registry through
+        // this hook: the shard of the thread that created it, so that threads
+        // creating lists at the same time seldom share a lock
+        IntrusiveListHook<> registryHook;
+        std::size_t registryShard;
+        using Registry = IntrusiveList<DoublyLinkedList,
+              IntrusiveMemberHook<DoublyLinkedList, void, &DoublyLinkedList::registryHook>>;
+        struct RegistryShard;
+        static RegistryShard & registry(std::size_t shard);
+
+    private:
+        // Iterators. Only node pointers are chased here: the hot path has no
+        // checks unless DLL_DEBUG_ITERATORS is defined at compile time.
+        template <bool Const>
+        class BasicIterator
+        {
+            public:
+                using iterator_category = std::bidirectional_iterator_tag;
+                using iterator_concept  = std::bidirectional_iterator_tag;
+                using value_type        = int;
+                using difference_type   = std::ptrdiff_t;
+                using pointer           = std::conditional_t<Const, const int*, int*>;
+                using reference         = std::conditional_t<Const, const int&, int&>;
+
+                BasicIterator() = default;
+                BasicIterator(const BasicIterator &) = default;
+                BasicIterator & operator=(const BasicIterator &) = default;
+                // iterator -> const_iterator
+                BasicIterator(const BasicIterator<false> & rhs) requires Const :
+                    current{rhs.current}
+                {
+                }
+
+                reference operator*() const
+                {
+                    checkDereferenceable();
+                    return current->value;
+                }
+                pointer operator->() const
+                {
+                    checkDereferenceable();
+                    return &current->value;
+                }
+                BasicIterator & operator++()
+                {
+                    if constexpr (dllCheckedIterators)
+                    {
+                        if (current == nullptr or current->next == nullptr)
+                            throw std::invalid_argument("Invalid iterator index");
+                    }
+                    current = current->next;
+                    return *this;
+                }
+                BasicIterator operator++(int)
+                {
+                    // We will return the iterator BEFORE incrementing its value
+                    BasicIterator iter = *this;
+                    ++*this;
+                    return iter;
+                }
+                BasicIterator & operator--()
+                {
+                    if constexpr (dllCheckedIterators)
+                    {
+                        if (current == nullptr or current->prev == nullptr or
+                                current->prev->prev == nullptr)
+                            throw std::invalid_argument("Invalid iterator index");
+                    }
+                    current = current->prev;
+                    return *this;
+                }
+                BasicIterator operator--(int)
+                {
+                    BasicIterator iter = *this;
+                    --*this;
+                    return iter;
+                }
+                friend bool operator==(const BasicIterator & lhs,
+                        const BasicIterator & rhs)
+                {
+                    return lhs.current == rhs.current;
+                }
+
+            private:
+                friend DoublyLinkedList;
+                friend BasicIterator<true>;
+                using NodePtr = std::conditional_t<Const, const Node*, Node*>;
+
+                explicit BasicIterator(NodePtr node) :
+                    current{node}
+                {
+                }
+                void checkDereferenceable() const
+                {
+                    if constexpr (dllCheckedIterators)
+                    {
+                        // Sentinels are the only nodes with a null link
+                        if (current == nullptr or current->next == nullptr or
+                                current->prev == nullptr)
+                            throw std::invalid_argument("Invalid dereference of end() iterator");
+                    }
+                }
+                NodePtr current{nullptr};
+        };
+
+    public:
+        using iterator               = BasicIterator<false>;
+        using const_iterator         = BasicIterator<true>;
+        using reverse_iterator       = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+        // Old name, kept for existing callers
+        using DoublyLinkedListIterator = iterator;
+
+        iterator begin() { return iterator(head->next); }
+        iterator end() { return iterator(tail); }
+        const_iterator begin() const { return const_iterator(head->next); }
+        const_iterator end() const { return const_iterator(tail); }
+        const_iterator cbegin() const { return begin(); }
+        const_iterator cend() const { return end(); }
+        reverse_iterator rbegin() { return reverse_iterator(end()); }
+        reverse_iterator rend() { return reverse_iterator(begin()); }
+        const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+        const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+        const_reverse_iterator crbegin() const { return rbegin(); }
+        const_reverse_iterator crend() const { return rend(); }
+
+    public:
+        // Handles. Inserts return an iterator to the new element, which stays
+        // valid until that element is erased: other inserts, removals, swaps
+        // and moves leave it alone, only compact() and maybeCompact()
+        // invalidate it. Apart from
+        // insertAt(), these are O(1) (plus a walk per record while the journal
+        // is enabled, since records hold positions).
+        iterator append(int value);
+        iterator prepend(int value);
+        iterator insertAt(int value, dllcnt_t pos);
+        // insertBefore(end(), value) appends
+        iterator insertBefore(const_iterator pos, int value);
+        iterator insertAfter(const_iterator pos, int value);
+        // Returns the element that followed the erased one
+        iterator erase(const_iterator pos);
+        void moveToFront(const_iterator pos);
+        void moveToBack(const_iterator pos);
+
+    private:
+        // Node behind a handle, throws std::invalid_argument for sentinels
+        Node* handleNode(const_iterator pos, bool endAllowed = false) const;
+        Node* link(Node* next, int value);
+        void unlink(Node* nd);
+        dllcnt_t positionOf(const Node* nd) const;
 };
 
+static_assert(std::bidirectional_iterator<DoublyLinkedList::iterator>);
+static_assert(std::bidirectional_iterator<DoublyLinkedList::const_iterator>);
+static_assert(std::ranges::bidirectional_range<DoublyLinkedList>);
+static_assert(std::ranges::sized_range<const DoublyLinkedList>);
+
 // Outside of the class: overload operator<<
 std::ostream & operator<<(std::ostream & out, const DoublyLinkedList & list);
+// Reads one list and stops right after its ']'. Malformed input sets
+// failbit and leaves the list untouched.
+std::istream & operator>>(std::istream & in, DoublyLinkedList & list);
 
 #endif  /* _DLL_H_ */
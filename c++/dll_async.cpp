@@ -0,0 +1,73 @@
+/*
+ * Filename:		dll_async.cpp
+ *
+ * Author:			Santiago Pagola
+ * Brief:			Implementation of the coroutine support defined in header
+ file dll_async.h.
+ * Last modified:	mån 19 okt 2026 11:02:17 CEST
+*/
+
+#include "dll_async.h"
+
+void LocalExecutor::post(std::coroutine_handle<> handle)
+{
+    ready.push_back(handle);
+}
+
+bool LocalExecutor::runOne()
+{
+    if (ready.empty())
+        return false;
+    std::coroutine_handle<> handle = ready.front();
+    ready.pop_front();
+    handle.resume();
+    return true;
+}
+
+void LocalExecutor::run()
+{
+    while (runOne())
+    {
+    }
+}
+
+int AsyncDoublyLinkedList::PopAwaiter::await_resume()
+{
+    if (handedOff)
+        return value;
+    // Ready path: the element is still in the list
+    int first = *owner.items.begin();
+    owner.items.removeFirst();
+    return first;
+}
+
+void AsyncDoublyLinkedList::append(int value)
+{
+    if (waiters.isEmpty())
+    {
+        items.append(value);
+        return;
+    }
+    // Hand the value straight to the oldest waiter, skipping the list
+    PopAwaiter & waiter = waiters.first();
+    waiters.removeFirst();
+    waiter.value = value;
+    waiter.handedOff = true;
+    executor.post(waiter.handle);
+}
+
+Generator elements(const DoublyLinkedList & list)
+{
+    for (int value : list)
+    {
+        co_yield value;
+    }
+}
+
+Generator reverseElements(const DoublyLinkedList & list)
+{
+    for (auto it = list.rbegin(); it != list.rend(); ++it)
+    {
+        co_yield *it;
+    }
+}
@@ -0,0 +1,190 @@
+/*
+ * Filename:		dll_async.h
+ *
+ * Author:			Santiago Pagola
+ * Brief:			Coroutine support for the Doubly Linked List: awaitable
+ pop(), lazy element generator and a minimal local executor.
+ * Last modified:	mån 19 okt 2026 11:02:17 CEST
+*/
+
+#ifndef __DLL_ASYNC_H_
+#define __DLL_ASYNC_H_
+
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <utility>
+
+#include "dll.h"
+#include "dll_intrusive.h"
+
+// Single-threaded run queue of ready coroutines. Nothing ever blocks: run()
+// returns as soon as no coroutine is ready anymore.
+class LocalExecutor
+{
+    public:
+        void post(std::coroutine_handle<> handle);
+        // Resume one ready coroutine, false if none was ready
+        bool runOne();
+        // Resume ready coroutines until none is left
+        void run();
+        bool isIdle() const { return ready.empty(); }
+
+    private:
+        std::deque<std::coroutine_handle<>> ready;
+};
+
+// Fire-and-forget coroutine: starts eagerly, frees itself when it finishes
+struct AsyncTask
+{
+    struct promise_type
+    {
+        AsyncTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// A list whose consumers can co_await elements. Waiting consumers are parked
+// (in FIFO order) until append() hands them a value; they are then resumed
+// through the executor, never inline from append().
+class AsyncDoublyLinkedList
+{
+    private:
+        class PopAwaiter : public IntrusiveListHook<>
+        {
+            public:
+                explicit PopAwaiter(AsyncDoublyLinkedList & _owner) : owner{_owner} {}
+                PopAwaiter(const PopAwaiter &) = delete;
+                // A consumer destroyed while waiting must not be resumed
+                ~PopAwaiter()
+                {
+                    if (isLinked())
+                        owner.waiters.remove(*this);
+                }
+
+                bool await_ready() const noexcept { return not owner.items.isEmpty(); }
+                void await_suspend(std::coroutine_handle<> _handle)
+                {
+                    handle = _handle;
+                    owner.waiters.append(*this);
+                }
+                int await_resume();
+
+            private:
+                friend AsyncDoublyLinkedList;
+                AsyncDoublyLinkedList & owner;
+                std::coroutine_handle<> handle;
+                bool handedOff{false};
+                int value{0};
+        };
+
+    public:
+        explicit AsyncDoublyLinkedList(LocalExecutor & _executor) : executor{_executor} {}
+        AsyncDoublyLinkedList(const AsyncDoublyLinkedList &) = delete;
+
+        void append(int value);
+        // co_await list.pop() yields the first element, suspending until there is one
+        PopAwaiter pop() { return PopAwaiter{*this}; }
+
+        dllcnt_t count() const { return items.count(); }
+        dllcnt_t waiting() const { return static_cast<dllcnt_t>(waiters.count()); }
+        const DoublyLinkedList & list() const { return items; }
+
+    private:
+        LocalExecutor & executor;
+        DoublyLinkedList items;
+        IntrusiveList<PopAwaiter> waiters;
+};
+
+// Lazily produced sequence of ints, consumed with range-for
+class Generator
+{
+    public:
+        struct promise_type
+        {
+            Generator get_return_object()
+            {
+                return Generator{std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            std::suspend_always yield_value(int _value) noexcept
+            {
+                value = _value;
+                return {};
+            }
+            void return_void() {}
+            void unhandled_exception() { exception = std::current_exception(); }
+
+            int value{0};
+            std::exception_ptr exception;
+        };
+
+        class iterator
+        {
+            public:
+                using iterator_concept = std::input_iterator_tag;
+                using value_type       = int;
+                using difference_type  = std::ptrdiff_t;
+
+                iterator() = default;
+                int operator*() const { return coroutine.promise().value; }
+                iterator & operator++()
+                {
+                    resume(coroutine);
+                    return *this;
+                }
+                void operator++(int) { ++*this; }
+                friend bool operator==(const iterator & it, std::default_sentinel_t)
+                {
+                    return not it.coroutine or it.coroutine.done();
+                }
+
+            private:
+                friend Generator;
+                explicit iterator(std::coroutine_handle<promise_type> _coroutine) :
+                    coroutine{_coroutine}
+                {
+                }
+                std::coroutine_handle<promise_type> coroutine;
+        };
+
+        Generator(Generator && rhs) noexcept : coroutine{std::exchange(rhs.coroutine, {})} {}
+        Generator(const Generator &) = delete;
+        ~Generator()
+        {
+            if (coroutine)
+                coroutine.destroy();
+        }
+
+        iterator begin()
+        {
+            resume(coroutine);
+            return iterator{coroutine};
+        }
+        std::default_sentinel_t end() const { return {}; }
+
+    private:
+        explicit Generator(std::coroutine_handle<promise_type> _coroutine) :
+            coroutine{_coroutine}
+        {
+        }
+        static void resume(std::coroutine_handle<promise_type> coroutine)
+        {
+            coroutine.resume();
+            if (coroutine.promise().exception)
+                std::rethrow_exception(coroutine.promise().exception);
+        }
+        std::coroutine_handle<promise_type> coroutine;
+};
+
+// Yield the elements of a list one at a time. The list must outlive the
+// generator and must not lose the element being visited while suspended.
+Generator elements(const DoublyLinkedList & list);
+Generator reverseElements(const DoublyLinkedList & list);
+
+#endif  /* __DLL_ASYNC_H_ */
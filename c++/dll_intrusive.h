@@ -0,0 +1,226 @@
+/*
+ * Filename:		dll_intrusive.h
+ *
+ * Author:			Santiago Pagola
+ * Brief:			Intrusive Doubly Linked List: links live inside the stored
+ objects themselves, so linking never allocates and unlinking is O(1).
+ * Last modified:	mån 19 okt 2026 10:12:40 CEST
+*/
+
+#ifndef __DLL_INTRUSIVE_H_
+#define __DLL_INTRUSIVE_H_
+
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+
+// Hook to embed in objects, either as a base class or as a member. The Tag
+// lets one class derive from several hooks to sit on several lists at once.
+template <typename Tag = void>
+class IntrusiveListHook
+{
+    public:
+        IntrusiveListHook() = default;
+        // Copying an object must not copy its links
+        IntrusiveListHook(const IntrusiveListHook &) {}
+        IntrusiveListHook & operator=(const IntrusiveListHook &) { return *this; }
+
+        bool isLinked() const { return next != nullptr; }
+
+    private:
+        template <typename, typename> friend class IntrusiveList;
+        IntrusiveListHook* next{nullptr};
+        IntrusiveListHook* prev{nullptr};
+};
+
+// Accessors telling an IntrusiveList where the hook lives in T
+template <typename T, typename Tag = void>
+struct IntrusiveBaseHook
+{
+    using Hook = IntrusiveListHook<Tag>;
+    static Hook* toHook(T* value) { return static_cast<Hook*>(value); }
+    static T* fromHook(Hook* hook) { return static_cast<T*>(hook); }
+};
+
+template <typename T, typename Tag, IntrusiveListHook<Tag> T::*Member>
+struct IntrusiveMemberHook
+{
+    using Hook = IntrusiveListHook<Tag>;
+    static Hook* toHook(T* value) { return &(value->*Member); }
+    static T* fromHook(Hook* hook)
+    {
+        return reinterpret_cast<T*>(reinterpret_cast<char*>(hook) - offset());
+    }
+
+    private:
+        static std::ptrdiff_t offset()
+        {
+            alignas(T) static char probe[sizeof(T)];
+            T* object = reinterpret_cast<T*>(probe);
+            return reinterpret_cast<char*>(&(object->*Member)) - probe;
+        }
+};
+
+// The list does not own its elements: destroying or clearing it only unlinks
+// them. An element must be unlinked before it is destroyed.
+template <typename T, typename HookAccess = IntrusiveBaseHook<T>>
+class IntrusiveList
+{
+    private:
+        using Hook = typename HookAccess::Hook;
+
+    public:
+        IntrusiveList()
+        {
+            // Circular around the sentinel: no branches on the list ends
+            sentinel.next = &sentinel;
+            sentinel.prev = &sentinel;
+        }
+        IntrusiveList(const IntrusiveList &) = delete;
+        IntrusiveList & operator=(const IntrusiveList &) = delete;
+        ~IntrusiveList() { clear(); }
+
+    private:
+        template <bool Const>
+        class BasicIterator
+        {
+            public:
+                using iterator_category = std::bidirectional_iterator_tag;
+                using iterator_concept  = std::bidirectional_iterator_tag;
+                using value_type        = T;
+                using difference_type   = std::ptrdiff_t;
+                using pointer           = std::conditional_t<Const, const T*, T*>;
+                using reference         = std::conditional_t<Const, const T&, T&>;
+
+                BasicIterator() = default;
+                BasicIterator(const BasicIterator &) = default;
+                BasicIterator & operator=(const BasicIterator &) = default;
+                BasicIterator(const BasicIterator<false> & rhs) requires Const :
+                    current{rhs.current}
+                {
+                }
+
+                reference operator*() const { return *HookAccess::fromHook(current); }
+                pointer operator->() const { return HookAccess::fromHook(current); }
+                BasicIterator & operator++() { current = current->next; return *this; }
+                BasicIterator operator++(int)
+                {
+                    BasicIterator iter = *this;
+                    current = current->next;
+                    return iter;
+                }
+                BasicIterator & operator--() { current = current->prev; return *this; }
+                BasicIterator operator--(int)
+                {
+                    BasicIterator iter = *this;
+                    current = current->prev;
+                    return iter;
+                }
+                friend bool operator==(const BasicIterator & lhs,
+                        const BasicIterator & rhs)
+                {
+                    return lhs.current == rhs.current;
+                }
+
+            private:
+                friend IntrusiveList;
+                friend BasicIterator<true>;
+                explicit BasicIterator(Hook* hook) :
+                    current{hook}
+                {
+                }
+                Hook* current{nullptr};
+        };
+
+    public:
+        using iterator       = BasicIterator<false>;
+        using const_iterator = BasicIterator<true>;
+
+        iterator begin() { return iterator(sentinel.next); }
+        iterator end() { return iterator(&sentinel); }
+        const_iterator begin() const { return const_iterator(sentinel.next); }
+        const_iterator end() const { return const_iterator(const_cast<Hook*>(&sentinel)); }
+
+        std::size_t count() const { return n; }
+        std::size_t size() const { return n; }
+        bool isEmpty() const { return n == 0; }
+
+        // Throw std::out_of_range on an empty list, like DoublyLinkedList
+        T & first() { return *HookAccess::fromHook(nonEmpty(sentinel.next)); }
+        T & last() { return *HookAccess::fromHook(nonEmpty(sentinel.prev)); }
+
+        void append(T & value) { link(sentinel.prev, HookAccess::toHook(&value)); }
+        void prepend(T & value) { link(&sentinel, HookAccess::toHook(&value)); }
+        void insertBefore(T & pos, T & value)
+        {
+            link(HookAccess::toHook(&pos)->prev, HookAccess::toHook(&value));
+        }
+        void insertAfter(T & pos, T & value)
+        {
+            link(HookAccess::toHook(&pos), HookAccess::toHook(&value));
+        }
+
+        // O(1): the element knows where it is linked
+        void remove(T & value) { unlink(HookAccess::toHook(&value)); }
+        void removeFirst() { unlink(nonEmpty(sentinel.next)); }
+        void removeLast() { unlink(nonEmpty(sentinel.prev)); }
+        void moveToFront(T & value)
+        {
+            Hook* hook = HookAccess::toHook(&value);
+            unlink(hook);
+            link(&sentinel, hook);
+        }
+        void moveToBack(T & value)
+        {
+            Hook* hook = HookAccess::toHook(&value);
+            unlink(hook);
+            link(sentinel.prev, hook);
+        }
+        iterator iteratorTo(T & value) { return iterator(HookAccess::toHook(&value)); }
+
+        void clear()
+        {
+            Hook* current = sentinel.next;
+            while (current != &sentinel)
+            {
+                Hook* next = current->next;
+                current->next = current->prev = nullptr;
+                current = next;
+            }
+            sentinel.next = sentinel.prev = &sentinel;
+            n = 0;
+        }
+
+    private:
+        // On an empty list both ends are the sentinel, which is no element
+        Hook* nonEmpty(Hook* end) const
+        {
+            if (n == 0)
+                throw std::out_of_range("Error: list empty");
+            return end;
+        }
+        void link(Hook* after, Hook* hook)
+        {
+            hook->prev = after;
+            hook->next = after->next;
+            after->next->prev = hook;
+            after->next = hook;
+            ++n;
+        }
+        void unlink(Hook* hook)
+        {
+            hook->prev->next = hook->next;
+            hook->next->prev = hook->prev;
+            hook->next = hook->prev = nullptr;
+            --n;
+        }
+
+        Hook sentinel;
+        std::size_t n{0};
+};
+
+template <typename T, typename Tag, IntrusiveListHook<Tag> T::*Member>
+using IntrusiveMemberList = IntrusiveList<T, IntrusiveMemberHook<T, Tag, Member>>;
+
+#endif  /* __DLL_INTRUSIVE_H_ */
@@ -0,0 +1,216 @@
+/*
+ * Filename:		dll_lru.h
+ *
+ * Author:			Santiago Pagola
+ * Brief:			Sharded LRU cache: a hash map to entries kept in recency
+ order on an intrusive Doubly Linked List.
+ * Last modified:	mån 19 okt 2026 11:40:05 CEST
+*/
+
+#ifndef __DLL_LRU_H_
+#define __DLL_LRU_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "dll_intrusive.h"
+
+// Every operation is O(1): the map finds the entry, and the entry's own hook
+// moves it to the front of (or off) the recency list without any walk.
+// Keys are spread over independently locked shards, so threads working on
+// different keys rarely contend.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class ShardedLruCache
+{
+    public:
+        struct Stats
+        {
+            std::uint64_t hits{0};
+            std::uint64_t misses{0};
+            std::uint64_t insertions{0};
+            std::uint64_t evictions{0};
+        };
+
+        // capacity is split evenly between the shards (rounded up)
+        explicit ShardedLruCache(std::size_t capacity,
+                std::size_t shardCount = std::thread::hardware_concurrency())
+        {
+            if (capacity == 0)
+                throw std::invalid_argument("Error: LRU capacity must be positive");
+            if (shardCount == 0)
+                shardCount = 1;
+            if (shardCount > capacity)
+                shardCount = capacity;
+            const std::size_t perShard = (capacity + shardCount - 1) / shardCount;
+            for (std::size_t i = 0; i < shardCount; ++i)
+            {
+                shards.emplace_back(std::make_unique<Shard>(perShard));
+            }
+        }
+        ShardedLruCache(const ShardedLruCache &) = delete;
+        ShardedLruCache & operator=(const ShardedLruCache &) = delete;
+
+        // Look up a key, making it the most recently used on a hit
+        std::optional<Value> get(const Key & key)
+        {
+            Shard & shard = shardFor(key);
+            std::lock_guard<std::mutex> guard{shard.lock};
+            auto found = shard.map.find(key);
+            if (found == shard.map.end())
+            {
+                ++shard.stats.misses;
+                return std::nullopt;
+            }
+            ++shard.stats.hits;
+            shard.recency.moveToFront(found->second);
+            return found->second.value;
+        }
+
+        // Insert or overwrite a key as the most recently used, evicting the
+        // least recently used entry of its shard when the shard is full
+        void put(const Key & key, Value value)
+        {
+            Shard & shard = shardFor(key);
+            std::lock_guard<std::mutex> guard{shard.lock};
+            auto [it, inserted] = shard.map.try_emplace(key);
+            Entry & entry = it->second;
+            entry.value = std::move(value);
+            if (not inserted)
+            {
+                shard.recency.moveToFront(entry);
+                return;
+            }
+            entry.key = &it->first;
+            shard.recency.prepend(entry);
+            ++shard.stats.insertions;
+            if (shard.map.size() > shard.capacity)
+            {
+                evictLast(shard);
+            }
+        }
+
+        // Mark a key as the most recently used, false if it is not cached
+        bool touch(const Key & key)
+        {
+            Shard & shard = shardFor(key);
+            std::lock_guard<std::mutex> guard{shard.lock};
+            auto found = shard.map.find(key);
+            if (found == shard.map.end())
+                return false;
+            shard.recency.moveToFront(found->second);
+            return true;
+        }
+
+        bool erase(const Key & key)
+        {
+            Shard & shard = shardFor(key);
+            std::lock_guard<std::mutex> guard{shard.lock};
+            auto found = shard.map.find(key);
+            if (found == shard.map.end())
+                return false;
+            shard.recency.remove(found->second);
+            shard.map.erase(found);
+            return true;
+        }
+
+        // Evict the least recently used entry of the shard owning key
+        // (false if that shard is empty)
+        bool evict(const Key & key)
+        {
+            Shard & shard = shardFor(key);
+            std::lock_guard<std::mutex> guard{shard.lock};
+            if (shard.recency.isEmpty())
+                return false;
+            evictLast(shard);
+            return true;
+        }
+
+        void clear()
+        {
+            for (auto & shard : shards)
+            {
+                std::lock_guard<std::mutex> guard{shard->lock};
+                shard->recency.clear();
+                shard->map.clear();
+            }
+        }
+
+        std::size_t size() const
+        {
+            std::size_t total = 0;
+            for (const auto & shard : shards)
+            {
+                std::lock_guard<std::mutex> guard{shard->lock};
+                total += shard->map.size();
+            }
+            return total;
+        }
+
+        std::size_t shardCount() const { return shards.size(); }
+
+        Stats stats() const
+        {
+            Stats total;
+            for (const auto & shard : shards)
+            {
+                std::lock_guard<std::mutex> guard{shard->lock};
+                total.hits += shard->stats.hits;
+                total.misses += shard->stats.misses;
+                total.insertions += shard->stats.insertions;
+                total.evictions += shard->stats.evictions;
+            }
+            return total;
+        }
+
+    private:
+        struct Entry : public IntrusiveListHook<>
+        {
+            const Key* key{nullptr};
+            Value value{};
+        };
+
+        // Aligned so that two shards' locks never share a cache line
+        struct alignas(64) Shard
+        {
+            explicit Shard(std::size_t _capacity) : capacity{_capacity} {}
+            ~Shard() { recency.clear(); }
+
+            mutable std::mutex lock;
+            // unordered_map never moves its elements, so hooks stay valid
+            std::unordered_map<Key, Entry, Hash> map;
+            IntrusiveList<Entry> recency;
+            std::size_t capacity;
+            Stats stats;
+        };
+
+        Shard & shardFor(const Key & key)
+        {
+            // Remix the hash so shard selection does not correlate with the
+            // bucket selection of the shard's own map
+            std::uint64_t h = static_cast<std::uint64_t>(Hash{}(key));
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            return *shards[h % shards.size()];
+        }
+
+        static void evictLast(Shard & shard)
+        {
+            Entry & victim = shard.recency.last();
+            shard.recency.removeLast();
+            // Erase by iterator: the key lives inside the erased element
+            shard.map.erase(shard.map.find(*victim.key));
+            ++shard.stats.evictions;
+        }
+
+        std::vector<std::unique_ptr<Shard>> shards;
+};
+
+#endif  /* __DLL_LRU_H_ */
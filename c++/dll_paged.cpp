@@ -0,0 +1,392 @@
+/*
+ * Filename:		dll_paged.cpp
+ *
+ * Author:			Santiago Pagola
+ * Brief:			Implementation of the out-of-core Doubly Linked List defined
+ in header file dll_paged.h.
+ * Last modified:	mån 19 okt 2026 13:21:48 CEST
+*/
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "dll_paged.h"
+
+static std::string pagedListStr{""};
+
+static void throwErrno(const char* what)
+{
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+// Whole-page transfers. Short transfers are resumed; one that cannot make
+// progress (end of file, full disk) leaves errno stale, so it reports EIO.
+static void readFully(int fd, char* buffer, std::size_t bytes, off_t offset)
+{
+    while (bytes > 0)
+    {
+        const ssize_t got = pread(fd, buffer, bytes, offset);
+        if (got < 0 and errno == EINTR)
+            continue;
+        if (got < 0)
+            throwErrno("Error: cannot read a page back");
+        if (got == 0)
+            throw std::system_error(EIO, std::generic_category(), "Error: page cut short in the backing file");
+        buffer += got;
+        bytes -= got;
+        offset += got;
+    }
+}
+
+static void writeFully(int fd, const char* buffer, std::size_t bytes, off_t offset)
+{
+    while (bytes > 0)
+    {
+        const ssize_t put = pwrite(fd, buffer, bytes, offset);
+        if (put < 0 and errno == EINTR)
+            continue;
+        if (put < 0)
+            throwErrno("Error: cannot spill a page");
+        if (put == 0)
+            throw std::system_error(EIO, std::generic_category(), "Error: cannot spill a page");
+        buffer += put;
+        bytes -= put;
+        offset += put;
+    }
+}
+
+PagedDoublyLinkedList::PagedDoublyLinkedList() :
+    PagedDoublyLinkedList(Options{})
+{
+}
+
+PagedDoublyLinkedList::PagedDoublyLinkedList(const Options & _options) :
+    options{_options}
+{
+    // Splitting a page needs both halves in memory at once
+    if (options.pageElements == 0 or options.maxResidentPages < 2)
+        throw std::invalid_argument("Error: pages must hold elements and at least 2 must fit in memory");
+
+    // The backing file is unlinked right away: it vanishes with the process
+    std::string path = options.directory + "/dll-paged-XXXXXX";
+    fd = mkstemp(path.data());
+    if (fd < 0)
+        throwErrno("Error: cannot create the backing file");
+    unlink(path.c_str());
+}
+
+PagedDoublyLinkedList::~PagedDoublyLinkedList()
+{
+    // Closing the unlinked file releases its blocks: no truncation needed
+    releasePages();
+    close(fd);
+}
+
+PagedDoublyLinkedList::Page* PagedDoublyLinkedList::newPage()
+{
+    // Evict first: if spilling fails, nothing was taken yet
+    if (resident.count() >= options.maxResidentPages)
+        evictOne();
+    // A new page starts resident and empty
+    std::unique_ptr<Page> page{new Page()};
+    page->data.reset(new int[options.pageElements]);
+    if (freeSlots.empty())
+    {
+        page->slot = nextSlot++;
+    }
+    else
+    {
+        page->slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    resident.prepend(*page);
+    return page.release();
+}
+
+void PagedDoublyLinkedList::freePage(Page* page)
+{
+    if (page->data)
+        resident.remove(*page);
+    pages.remove(*page);
+    freeSlots.push_back(page->slot);
+    delete page;
+}
+
+int* PagedDoublyLinkedList::load(Page* page) const
+{
+    if (page->data)
+    {
+        resident.moveToFront(*page);
+        return page->data.get();
+    }
+
+    if (resident.count() >= options.maxResidentPages)
+        evictOne();
+    // The page only gets its data once it is read: resident pages are
+    // exactly those holding data
+    const std::size_t bytes = options.pageElements * sizeof(int);
+    std::unique_ptr<int[]> data{new int[options.pageElements]};
+    if (page->onDisk)
+    {
+        readFully(fd, reinterpret_cast<char*>(data.get()), bytes,
+                static_cast<off_t>(page->slot * bytes));
+        ++counters.pageReads;
+    }
+    page->data = std::move(data);
+    page->dirty = false;
+    resident.prepend(*page);
+    return page->data.get();
+}
+
+void PagedDoublyLinkedList::evictOne() const
+{
+    // Written out before being unlinked: if writing throws, the victim stays
+    // resident and consistent
+    Page & victim = resident.last();
+    if (victim.dirty or not victim.onDisk)
+    {
+        const std::size_t bytes = options.pageElements * sizeof(int);
+        writeFully(fd, reinterpret_cast<const char*>(victim.data.get()), bytes,
+                static_cast<off_t>(victim.slot * bytes));
+        ++counters.pageWrites;
+        victim.onDisk = true;
+        victim.dirty = false;
+    }
+    resident.removeLast();
+    victim.data.reset();
+}
+
+void PagedDoublyLinkedList::readAhead(const Page* page) const
+{
+    const std::size_t bytes = options.pageElements * sizeof(int);
+    Page* next = const_cast<Page*>(page);
+    for (std::size_t i = 0; i < options.readAheadPages; ++i)
+    {
+        next = nextPage(next);
+        if (next == nullptr)
+            break;
+        if (not next->data and next->onDisk)
+            posix_fadvise(fd, static_cast<off_t>(next->slot * bytes),
+                    static_cast<off_t>(bytes), POSIX_FADV_WILLNEED);
+    }
+}
+
+PagedDoublyLinkedList::Page* PagedDoublyLinkedList::nextPage(Page* page) const
+{
+    auto it = pages.iteratorTo(*page);
+    ++it;
+    return it == pages.end() ? nullptr : &*it;
+}
+
+PagedDoublyLinkedList::Page* PagedDoublyLinkedList::locate(dllcnt_t pos,
+        dllcnt_t & offset) const
+{
+    if (pos >= n)
+        throw std::out_of_range("Error: index out of range");
+
+    // Only page metadata is touched: no page gets loaded while searching.
+    // Start from the end closer to pos.
+    if (pos < n - pos)
+    {
+        for (Page & page : pages)
+        {
+            if (pos < page.count)
+            {
+                offset = pos;
+                return &page;
+            }
+            pos -= page.count;
+        }
+    }
+    else
+    {
+        dllcnt_t fromBack = n - 1 - pos;
+        for (auto it = pages.iteratorTo(pages.last()); ; --it)
+        {
+            if (fromBack < it->count)
+            {
+                offset = it->count - 1 - fromBack;
+                return &*it;
+            }
+            fromBack -= it->count;
+        }
+    }
+    return nullptr;
+}
+
+int PagedDoublyLinkedList::at(dllcnt_t pos) const
+{
+    dllcnt_t offset;
+    Page* page = locate(pos, offset);
+    return load(page)[offset];
+}
+
+void PagedDoublyLinkedList::setAt(dllcnt_t pos, int value)
+{
+    dllcnt_t offset;
+    Page* page = locate(pos, offset);
+    load(page)[offset] = value;
+    page->dirty = true;
+}
+
+void PagedDoublyLinkedList::append(int value)
+{
+    if (pages.isEmpty() or pages.last().count == options.pageElements)
+        pages.append(*newPage());
+    Page* page = &pages.last();
+    load(page)[page->count++] = value;
+    page->dirty = true;
+    ++n;
+}
+
+void PagedDoublyLinkedList::prepend(int value)
+{
+    if (pages.isEmpty() or pages.first().count == options.pageElements)
+        pages.prepend(*newPage());
+    Page* page = &pages.first();
+    int* data = load(page);
+    std::memmove(data + 1, data, page->count * sizeof(int));
+    data[0] = value;
+    ++page->count;
+    page->dirty = true;
+    ++n;
+}
+
+void PagedDoublyLinkedList::insertAt(int value, dllcnt_t pos)
+{
+    dllcnt_t offset;
+    Page* page = locate(pos, offset);
+    int* data = load(page);
+
+    if (page->count == options.pageElements)
+    {
+        // Split: the upper half moves to a new page right after this one
+        const dllcnt_t half = page->count / 2;
+        Page* upper = newPage();
+        pages.insertAfter(*page, *upper);
+        // newPage() may have evicted our page
+        data = load(page);
+        std::memcpy(upper->data.get(), data + half, (page->count - half) * sizeof(int));
+        upper->count = page->count - half;
+        upper->dirty = true;
+        page->count = half;
+        if (offset >= half)
+        {
+            page = upper;
+            offset -= half;
+        }
+        data = load(page);
+    }
+    std::memmove(data + offset + 1, data + offset, (page->count - offset) * sizeof(int));
+    data[offset] = value;
+    ++page->count;
+    page->dirty = true;
+    ++n;
+}
+
+void PagedDoublyLinkedList::removeAt(dllcnt_t pos)
+{
+    dllcnt_t offset;
+    Page* page = locate(pos, offset);
+    int* data = load(page);
+    std::memmove(data + offset, data + offset + 1, (page->count - offset - 1) * sizeof(int));
+    --n;
+    if (--page->count == 0)
+        freePage(page);
+    else
+        page->dirty = true;
+}
+
+void PagedDoublyLinkedList::removeFirst()
+{
+    if (n == 0)
+        throw std::out_of_range("Error: list empty");
+    removeAt(0);
+}
+
+void PagedDoublyLinkedList::removeLast()
+{
+    if (n == 0)
+        throw std::out_of_range("Error: list empty");
+    removeAt(n - 1);
+}
+
+void PagedDoublyLinkedList::releasePages()
+{
+    while (not pages.isEmpty())
+    {
+        freePage(&pages.first());
+    }
+    freeSlots.clear();
+    nextSlot = 0;
+    n = 0;
+}
+
+void PagedDoublyLinkedList::clear()
+{
+    releasePages();
+    if (ftruncate(fd, 0) != 0)
+        throwErrno("Error: cannot truncate the backing file");
+}
+
+std::string const & PagedDoublyLinkedList::toString() const
+{
+    pagedListStr.clear();
+    pagedListStr += "[";
+    bool first = true;
+    for (int value : *this)
+    {
+        if (not first)
+            pagedListStr += ",";
+        pagedListStr += std::to_string(value);
+        first = false;
+    }
+    pagedListStr += "]";
+    return pagedListStr;
+}
+
+PagedDoublyLinkedList::Stats PagedDoublyLinkedList::stats() const
+{
+    Stats result = counters;
+    result.residentPages = resident.count();
+    result.pages = pages.count();
+    return result;
+}
+
+PagedDoublyLinkedList::const_iterator PagedDoublyLinkedList::begin() const
+{
+    if (pages.isEmpty())
+        return end();
+    Page* first = &pages.first();
+    load(first);
+    readAhead(first);
+    return const_iterator(this, first);
+}
+
+PagedDoublyLinkedList::const_iterator::reference
+PagedDoublyLinkedList::const_iterator::operator*() const
+{
+    // Another access may have evicted the page since we entered it
+    return (page->data ? page->data.get() : owner->load(page))[index];
+}
+
+PagedDoublyLinkedList::const_iterator &
+PagedDoublyLinkedList::const_iterator::operator++()
+{
+    if (++index < page->count)
+        return *this;
+    page = owner->nextPage(page);
+    index = 0;
+    if (page)
+    {
+        owner->load(page);
+        owner->readAhead(page);
+    }
+    return *this;
+}
@@ -0,0 +1,148 @@
+/*
+ * Filename:		dll_paged.h
+ *
+ * Author:			Santiago Pagola
+ * Brief:			Out-of-core Doubly Linked List: elements are grouped in
+ pages, and only a bounded number of pages is kept in memory. Cold pages are
+ spilled to a local backing file.
+ * Last modified:	mån 19 okt 2026 13:21:48 CEST
+*/
+
+#ifndef __DLL_PAGED_H_
+#define __DLL_PAGED_H_
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dll.h"
+#include "dll_intrusive.h"
+
+// Same positional API as DoublyLinkedList, for lists bigger than RAM. The
+// list is a doubly linked list of pages of up to pageElements values; page
+// metadata always stays in memory, page contents are loaded on demand and the
+// least recently used ones are written back to an unlinked temporary file.
+// Iteration reads ahead: entering a page asks the kernel to start fetching
+// the next readAheadPages pages from the backing file.
+class PagedDoublyLinkedList
+{
+    public:
+        struct Options
+        {
+            std::string directory{"/tmp"};
+            dllcnt_t pageElements{4096};
+            std::size_t maxResidentPages{64}; // at least 2
+            std::size_t readAheadPages{4};
+        };
+
+        struct Stats
+        {
+            std::uint64_t pageReads{0};
+            std::uint64_t pageWrites{0};
+            std::size_t residentPages{0};
+            std::size_t pages{0};
+        };
+
+        PagedDoublyLinkedList();
+        explicit PagedDoublyLinkedList(const Options & options);
+        PagedDoublyLinkedList(const PagedDoublyLinkedList &) = delete;
+        PagedDoublyLinkedList & operator=(const PagedDoublyLinkedList &) = delete;
+        ~PagedDoublyLinkedList();
+
+    private:
+        struct OrderTag;
+        struct ResidentTag;
+        struct Page :
+            public IntrusiveListHook<OrderTag>,
+            public IntrusiveListHook<ResidentTag>
+        {
+            std::unique_ptr<int[]> data;
+            dllcnt_t count{0};
+            std::uint64_t slot{0};
+            bool dirty{false};
+            bool onDisk{false};
+        };
+        using PageList = IntrusiveList<Page, IntrusiveBaseHook<Page, OrderTag>>;
+        using ResidentList = IntrusiveList<Page, IntrusiveBaseHook<Page, ResidentTag>>;
+
+    public:
+        class const_iterator
+        {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type        = int;
+                using difference_type   = std::ptrdiff_t;
+                using pointer           = const int*;
+                using reference         = const int&;
+
+                const_iterator() = default;
+                reference operator*() const;
+                const_iterator & operator++();
+                const_iterator operator++(int)
+                {
+                    const_iterator iter = *this;
+                    ++*this;
+                    return iter;
+                }
+                friend bool operator==(const const_iterator & lhs,
+                        const const_iterator & rhs)
+                {
+                    return lhs.page == rhs.page and lhs.index == rhs.index;
+                }
+
+            private:
+                friend PagedDoublyLinkedList;
+                const_iterator(const PagedDoublyLinkedList* _owner, Page* _page) :
+                    owner{_owner},
+                    page{_page}
+                {
+                }
+                const PagedDoublyLinkedList* owner{nullptr};
+                Page* page{nullptr};
+                dllcnt_t index{0};
+        };
+
+        const_iterator begin() const;
+        const_iterator end() const { return const_iterator(this, nullptr); }
+
+        int at(dllcnt_t pos) const;
+        dllcnt_t count() const { return n; }
+        dllcnt_t size() const { return n; }
+        bool isEmpty() const { return n == 0; }
+        void append(int value);
+        void prepend(int value);
+        void insertAt(int value, dllcnt_t pos);
+        void removeAt(dllcnt_t pos);
+        void removeFirst();
+        void removeLast();
+        void setAt(dllcnt_t pos, int value);
+        void clear();
+        std::string const & toString() const;
+        Stats stats() const;
+
+    private:
+        Page* newPage();
+        void freePage(Page* page);
+        // Free every page, without touching the backing file (never throws)
+        void releasePages();
+        // Make a page resident (evicting as needed) and mark it most recent
+        int* load(Page* page) const;
+        void evictOne() const;
+        void readAhead(const Page* page) const;
+        // Page holding position pos, and pos's offset inside it
+        Page* locate(dllcnt_t pos, dllcnt_t & offset) const;
+        Page* nextPage(Page* page) const;
+
+        Options options;
+        int fd{-1};
+        dllcnt_t n{0};
+        mutable PageList pages;
+        mutable ResidentList resident;
+        std::vector<std::uint64_t> freeSlots;
+        std::uint64_t nextSlot{0};
+        mutable Stats counters;
+};
+
+#endif  /* __DLL_PAGED_H_ */
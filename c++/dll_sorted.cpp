@@ -0,0 +1,234 @@
+/*
+ * Filename:		dll_sorted.cpp
+ *
+ * Author:			Santiago Pagola
+ * Brief:			Implementation of the sorted Doubly Linked List defined in
+ header file dll_sorted.h.
+ * Last modified:	mån 19 okt 2026 15:02:37 CEST
+*/
+
+#include <bit>
+#include <new>
+#include <stdexcept>
+
+#include "dll_sorted.h"
+
+static std::string sortedListStr{""};
+
+SortedDoublyLinkedList::SortedDoublyLinkedList() :
+    head{newNode(0, MaxLevel)},
+    tail{newNode(0, 1)}
+{
+    for (int level = 0; level < MaxLevel; ++level)
+    {
+        head->lanes()[level] = Lane{tail, 1};
+    }
+    head->prev = nullptr;
+    tail->prev = head;
+    tail->lanes()[0] = Lane{nullptr, 0};
+}
+
+SortedDoublyLinkedList::SortedDoublyLinkedList(std::initializer_list<int> values) :
+    SortedDoublyLinkedList()
+{
+    for (int value : values)
+    {
+        insertSorted(value);
+    }
+}
+
+SortedDoublyLinkedList::~SortedDoublyLinkedList()
+{
+    clear();
+    freeNode(head);
+    freeNode(tail);
+}
+
+SortedDoublyLinkedList::Node* SortedDoublyLinkedList::newNode(int value, int height)
+{
+    void* memory = ::operator new(sizeof(Node) + height * sizeof(Lane));
+    Node* node = new (memory) Node{nullptr, value, height};
+    return node;
+}
+
+void SortedDoublyLinkedList::freeNode(Node* node)
+{
+    ::operator delete(node);
+}
+
+int SortedDoublyLinkedList::randomHeight()
+{
+    // xorshift64*, then one more level for every 2 trailing zero bits
+    seed ^= seed >> 12;
+    seed ^= seed << 25;
+    seed ^= seed >> 27;
+    const std::uint64_t bits = seed * 0x2545f4914f6cdd1d;
+    const int height = 1 + std::countr_zero(bits | (1ull << 62)) / 2;
+    return height < MaxLevel ? height : MaxLevel;
+}
+
+SortedDoublyLinkedList::Node* SortedDoublyLinkedList::search(int value,
+        bool orEqual, Node** update, dllcnt_t* ranks) const
+{
+    Node* node = head;
+    dllcnt_t rank = 0;
+    for (int level = levels - 1; level >= 0; --level)
+    {
+        for (;;)
+        {
+            const Lane & lane = node->lanes()[level];
+            if (lane.next == tail or lane.next->value > value
+                    or (lane.next->value == value and not orEqual))
+                break;
+            rank += lane.width;
+            node = lane.next;
+        }
+        if (update)
+            update[level] = node;
+        if (ranks)
+            ranks[level] = rank;
+    }
+    return node;
+}
+
+SortedDoublyLinkedList::const_iterator SortedDoublyLinkedList::insertSorted(int value)
+{
+    Node* update[MaxLevel];
+    dllcnt_t ranks[MaxLevel];
+    search(value, true, update, ranks);
+    // Position of the new node's predecessor (0: head)
+    const dllcnt_t rank = ranks[0];
+
+    const int height = randomHeight();
+    for (; levels < height; ++levels)
+    {
+        update[levels] = head;
+        ranks[levels] = 0;
+        head->lanes()[levels].width = n + 1;
+    }
+
+    Node* node = newNode(value, height);
+    for (int level = 0; level < height; ++level)
+    {
+        Lane & before = update[level]->lanes()[level];
+        const dllcnt_t skipped = rank - ranks[level];
+        node->lanes()[level] = Lane{before.next, before.width - skipped};
+        before = Lane{node, skipped + 1};
+    }
+    // Lanes flying over the new node get one element longer
+    for (int level = height; level < levels; ++level)
+    {
+        update[level]->lanes()[level].width++;
+    }
+    node->prev = update[0];
+    node->next()->prev = node;
+    ++n;
+    return const_iterator(node);
+}
+
+SortedDoublyLinkedList::const_iterator SortedDoublyLinkedList::lower_bound(int value) const
+{
+    return const_iterator(search(value, false, nullptr, nullptr)->next());
+}
+
+SortedDoublyLinkedList::const_iterator SortedDoublyLinkedList::upper_bound(int value) const
+{
+    return const_iterator(search(value, true, nullptr, nullptr)->next());
+}
+
+bool SortedDoublyLinkedList::contains(int value) const
+{
+    const_iterator iter = lower_bound(value);
+    return iter != end() and *iter == value;
+}
+
+bool SortedDoublyLinkedList::erase(int value)
+{
+    Node* update[MaxLevel];
+    Node* node = search(value, false, update, nullptr)->next();
+    if (node == tail or node->value != value)
+        return false;
+
+    for (int level = 0; level < levels; ++level)
+    {
+        Lane & before = update[level]->lanes()[level];
+        if (before.next == node)
+        {
+            before.next = node->lanes()[level].next;
+            before.width += node->lanes()[level].width - 1;
+        }
+        else
+        {
+            before.width--;
+        }
+    }
+    node->next()->prev = node->prev;
+    freeNode(node);
+    --n;
+    while (levels > 1 and head->lanes()[levels - 1].next == tail)
+    {
+        --levels;
+    }
+    return true;
+}
+
+dllcnt_t SortedDoublyLinkedList::rank(int value) const
+{
+    dllcnt_t ranks[MaxLevel];
+    search(value, false, nullptr, ranks);
+    return ranks[0];
+}
+
+int SortedDoublyLinkedList::at(dllcnt_t pos) const
+{
+    if (pos >= n)
+        throw std::out_of_range("Error: index out of range");
+
+    // Node positions start at 1, the head being 0
+    Node* node = head;
+    dllcnt_t rank = 0;
+    for (int level = levels - 1; level >= 0; --level)
+    {
+        while (node->lanes()[level].next != tail
+                and rank + node->lanes()[level].width <= pos + 1)
+        {
+            rank += node->lanes()[level].width;
+            node = node->lanes()[level].next;
+        }
+    }
+    return node->value;
+}
+
+void SortedDoublyLinkedList::clear()
+{
+    Node* node = head->next();
+    while (node != tail)
+    {
+        Node* next = node->next();
+        freeNode(node);
+        node = next;
+    }
+    for (int level = 0; level < MaxLevel; ++level)
+    {
+        head->lanes()[level] = Lane{tail, 1};
+    }
+    tail->prev = head;
+    levels = 1;
+    n = 0;
+}
+
+std::string const & SortedDoublyLinkedList::toString() const
+{
+    sortedListStr.clear();
+    sortedListStr += "[";
+    bool first = true;
+    for (int value : *this)
+    {
+        if (not first)
+            sortedListStr += ",";
+        sortedListStr += std::to_string(value);
+        first = false;
+    }
+    sortedListStr += "]";
+    return sortedListStr;
+}
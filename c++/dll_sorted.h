@@ -0,0 +1,146 @@
+/*
+ * Filename:		dll_sorted.h
+ *
+ * Author:			Santiago Pagola
+ * Brief:			Sorted Doubly Linked List with skip-list express lanes, for
+ ordered insertion, lookup and rank queries in expected O(log n).
+ * Last modified:	mån 19 okt 2026 15:02:37 CEST
+*/
+
+#ifndef __DLL_SORTED_H_
+#define __DLL_SORTED_H_
+
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <string>
+
+#include "dll.h"
+
+// Values are kept in ascending order on a doubly linked list between head and
+// tail sentinels, as in DoublyLinkedList. On top of it, each node carries a
+// random number of express lanes (1 in 4 nodes reaches level 2, 1 in 16 level
+// 3, ...) linking it to the next node that is at least as tall, together with
+// the number of elements the link skips over. Searches run down the lanes, so
+// lookups and insertions visit O(log n) nodes, and summing the skipped widths
+// yields positions. Iteration only follows the base links, in both directions.
+// Equal values are kept in insertion order.
+class SortedDoublyLinkedList
+{
+    private:
+        static constexpr int MaxLevel = 32;
+
+        struct Node;
+        struct Lane
+        {
+            Node* next;
+            // Distance to next in base links (1 on level 0)
+            dllcnt_t width;
+        };
+        // Allocated along with its lanes, which follow it in memory
+        struct Node
+        {
+            Node* prev;
+            int value;
+            int height;
+            Lane* lanes() { return reinterpret_cast<Lane*>(this + 1); }
+            Node* next() { return lanes()[0].next; }
+        };
+
+    public:
+        class const_iterator
+        {
+            public:
+                using iterator_category = std::bidirectional_iterator_tag;
+                using value_type        = int;
+                using difference_type   = std::ptrdiff_t;
+                using pointer           = const int*;
+                using reference         = const int&;
+
+                const_iterator() = default;
+                reference operator*() const { return node->value; }
+                pointer operator->() const { return &node->value; }
+                const_iterator & operator++()
+                {
+                    node = node->next();
+                    return *this;
+                }
+                const_iterator operator++(int)
+                {
+                    const_iterator iter = *this;
+                    ++*this;
+                    return iter;
+                }
+                const_iterator & operator--()
+                {
+                    node = node->prev;
+                    return *this;
+                }
+                const_iterator operator--(int)
+                {
+                    const_iterator iter = *this;
+                    --*this;
+                    return iter;
+                }
+                friend bool operator==(const const_iterator & lhs,
+                        const const_iterator & rhs)
+                {
+                    return lhs.node == rhs.node;
+                }
+
+            private:
+                friend SortedDoublyLinkedList;
+                explicit const_iterator(Node* _node) : node{_node} {}
+                Node* node{nullptr};
+        };
+        // Values cannot be written through iterators: that could break the order
+        using iterator               = const_iterator;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        SortedDoublyLinkedList();
+        SortedDoublyLinkedList(std::initializer_list<int> values);
+        SortedDoublyLinkedList(const SortedDoublyLinkedList &) = delete;
+        SortedDoublyLinkedList & operator=(const SortedDoublyLinkedList &) = delete;
+        ~SortedDoublyLinkedList();
+
+        const_iterator begin() const { return const_iterator(head->next()); }
+        const_iterator end() const { return const_iterator(tail); }
+        const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+        const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+        dllcnt_t count() const { return n; }
+        dllcnt_t size() const { return n; }
+        bool isEmpty() const { return n == 0; }
+
+        // Insert after any equal values, returns the new element
+        const_iterator insertSorted(int value);
+        // First element not less than / greater than value
+        const_iterator lower_bound(int value) const;
+        const_iterator upper_bound(int value) const;
+        bool contains(int value) const;
+        // Remove the first element equal to value, if any
+        bool erase(int value);
+        // Number of elements less than value
+        dllcnt_t rank(int value) const;
+        // Element at position pos, found through the lane widths
+        int at(dllcnt_t pos) const;
+        void clear();
+        std::string const & toString() const;
+
+    private:
+        static Node* newNode(int value, int height);
+        static void freeNode(Node* node);
+        int randomHeight();
+        // Last node of each level before the first element that is not
+        // less than (orEqual: greater than) value; returns the base one
+        Node* search(int value, bool orEqual, Node** update, dllcnt_t* ranks) const;
+
+        Node* head;
+        Node* tail;
+        dllcnt_t n{0};
+        // Levels currently in use by the head's lanes
+        int levels{1};
+        std::uint64_t seed{0x9e3779b97f4a7c15};
+};
+
+#endif  /* __DLL_SORTED_H_ */
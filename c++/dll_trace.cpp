@@ -0,0 +1,228 @@
+/*
+ * Filename:		dll_trace.cpp
+ *
+ * Author:			Santiago Pagola
+ * Brief:			Implementation of the operation tracing defined in header
+ file dll_trace.h.
+ * Last modified:	mån 19 okt 2026 16:10:52 CEST
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <ostream>
+
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "dll_trace.h"
+
+namespace
+{
+    struct Event
+    {
+        const DllTrace::Op* op;
+        const void* list;
+        dllcnt_t size;
+        std::uint64_t args[2];
+        std::uint64_t start;
+        std::uint64_t end;
+    };
+
+    // One per thread that recorded something. When its thread exits, a ring
+    // is retired rather than freed: dumps still see the events of finished
+    // threads, until a new thread takes it over (see createRing())
+    struct Ring
+    {
+        Event events[DllTrace::capacity];
+        // Events ever recorded; the last `capacity` are kept
+        std::atomic<std::size_t> written{0};
+        // Events recorded before the last clear(), never dumped
+        std::atomic<std::size_t> cleared{0};
+        unsigned tid{0};
+        // When its thread exited (in ring retirements), 0 while in use
+        std::uint64_t retired{0};
+        Ring* next{nullptr};
+    };
+
+    std::mutex ringsLock;
+    Ring* rings{nullptr};
+    unsigned tids{0};
+    std::uint64_t retirements{0};
+
+    thread_local Ring* ring{nullptr};
+
+    // Retires the thread's ring when the thread exits. Kept apart from
+    // `ring`, which stays a plain pointer on the recording path.
+    struct RingRetirer
+    {
+        Ring* owned{nullptr};
+        ~RingRetirer()
+        {
+            if (owned == nullptr)
+                return;
+            ring = nullptr;
+            std::lock_guard<std::mutex> guard{ringsLock};
+            owned->retired = ++retirements;
+        }
+    };
+    thread_local RingRetirer retirer;
+    // Set while a traced call runs, so the calls it makes are not recorded
+    thread_local bool busy{false};
+
+    // Clock reading and time when tracing was first enabled, to convert
+    // clock ticks into microseconds
+    std::uint64_t epochTicks{0};
+    std::chrono::steady_clock::time_point epoch{};
+
+    // The time stamp counter where there is one: a few cycles instead of a
+    // clock_gettime() call
+    std::uint64_t ticks()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // Past keptRings retired rings, a new thread takes over the oldest one
+    // and its events are dropped: memory stays bounded by the threads alive
+    // plus keptRings, even when threads come and go per task
+    Ring* createRing()
+    {
+        std::lock_guard<std::mutex> guard{ringsLock};
+        std::size_t retired = 0;
+        Ring* oldest = nullptr;
+        for (Ring* current = rings; current != nullptr; current = current->next)
+        {
+            if (current->retired == 0)
+                continue;
+            ++retired;
+            if (oldest == nullptr or current->retired < oldest->retired)
+                oldest = current;
+        }
+
+        Ring* created = oldest;
+        if (retired >= DllTrace::keptRings)
+        {
+            created->retired = 0;
+            created->written.store(0);
+            created->cleared.store(0);
+        }
+        else
+        {
+            created = new Ring();
+            created->next = rings;
+            rings = created;
+        }
+        created->tid = ++tids;
+        retirer.owned = created;
+        return created;
+    }
+}
+
+void DllTrace::enable()
+{
+    {
+        std::lock_guard<std::mutex> guard{ringsLock};
+        if (epochTicks == 0)
+        {
+            epoch = std::chrono::steady_clock::now();
+            epochTicks = ticks();
+        }
+    }
+    on.store(true);
+}
+
+void DllTrace::disable()
+{
+    on.store(false);
+}
+
+void DllTrace::clear()
+{
+    // Only the owner thread writes a ring's count: clearing moves the dump's
+    // starting point instead
+    std::lock_guard<std::mutex> guard{ringsLock};
+    for (Ring* current = rings; current != nullptr; current = current->next)
+    {
+        current->cleared.store(current->written.load());
+    }
+}
+
+void DllTrace::Scope::begin(const Op & _op, const void* _list, dllcnt_t _size,
+        std::uint64_t first, std::uint64_t second)
+{
+    if (busy)
+        return;
+    busy = true;
+    op = &_op;
+    list = _list;
+    size = _size;
+    args[0] = first;
+    args[1] = second;
+    start = ticks();
+}
+
+void DllTrace::Scope::end()
+{
+    const std::uint64_t stop = ticks();
+    busy = false;
+    if (ring == nullptr)
+        ring = createRing();
+
+    // Single writer: fill the slot, then publish it
+    const std::size_t written = ring->written.load(std::memory_order_relaxed);
+    ring->events[written % capacity] = Event{op, list, size, {args[0], args[1]}, start, stop};
+    ring->written.store(written + 1, std::memory_order_release);
+}
+
+void DllTrace::dump(std::ostream & out)
+{
+    std::lock_guard<std::mutex> guard{ringsLock};
+
+    // Clock ticks per microsecond, measured over the time since enable()
+    const double us = std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - epoch).count();
+    const std::uint64_t elapsed = ticks() - epochTicks;
+    const double scale = us > 0.0 and elapsed > 0 ? elapsed / us : 1000.0;
+    const long pid = static_cast<long>(getpid());
+
+    bool first = true;
+    char line[512];
+    out << "{\"traceEvents\":[";
+    for (const Ring* current = rings; current != nullptr; current = current->next)
+    {
+        const std::size_t written = current->written.load(std::memory_order_acquire);
+        const std::size_t from = std::max(written > capacity ? written - capacity : 0,
+                current->cleared.load());
+        for (std::size_t i = from; i < written; ++i)
+        {
+            const Event & event = current->events[i % capacity];
+            int length = std::snprintf(line, sizeof line,
+                    "%s\n{\"name\":\"DoublyLinkedList::%s\",\"cat\":\"dll\",\"ph\":\"X\","
+                    "\"pid\":%ld,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+                    "\"args\":{\"list\":\"%p\",\"size\":%llu",
+                    first ? "" : ",", event.op->name, pid, current->tid,
+                    (event.start - epochTicks) / scale, (event.end - event.start) / scale,
+                    event.list, static_cast<unsigned long long>(event.size));
+            const char* names[2] = {event.op->firstArg, event.op->secondArg};
+            for (int arg = 0; arg < 2; ++arg)
+            {
+                if (names[arg])
+                    length += std::snprintf(line + length, sizeof line - length, ",\"%s\":%llu",
+                            names[arg], static_cast<unsigned long long>(event.args[arg]));
+            }
+            out.write(line, length);
+            out << "}}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+}
@@ -0,0 +1,87 @@
+/*
+ * Filename:		dll_trace.h
+ *
+ * Author:			Santiago Pagola
+ * Brief:			Operation tracing for the Doubly Linked List: per-thread ring
+ buffers of timed calls, exported as Chrome trace-event JSON.
+ * Last modified:	mån 19 okt 2026 16:10:52 CEST
+*/
+
+#ifndef __DLL_TRACE_H_
+#define __DLL_TRACE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+
+#include "dll.h"
+
+// While enabled, DoublyLinkedList's modifiers and lookups record an event per
+// call: operation, list, list size when called, positions involved, start and
+// duration. Calls made by a traced call are not recorded on their own. Events
+// go to a ring buffer of the calling thread, without locks or atomic
+// read-modify-writes, which keeps the last `capacity` events. dump() writes all
+// rings as Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev).
+// Rings outlive their threads; past `keptRings` rings of finished threads,
+// new threads take over the oldest ones.
+// When disabled, a call pays one relaxed atomic load.
+class DllTrace
+{
+    public:
+        static constexpr std::size_t capacity = 16384;
+        static constexpr std::size_t keptRings = 8;
+
+        static void enable();
+        static void disable();
+        static bool enabled() { return on.load(std::memory_order_relaxed); }
+        // Safe while other threads record: their events recorded meanwhile
+        // may be dropped or kept
+        static void clear();
+        // Events being recorded meanwhile by other threads may show half
+        // written: disable tracing first for an exact dump
+        static void dump(std::ostream & out);
+
+        struct Op
+        {
+            const char* name;
+            // Names of the recorded arguments, null if unused
+            const char* firstArg;
+            const char* secondArg;
+        };
+
+        // Records the call it is declared in when it goes out of scope
+        class Scope
+        {
+            public:
+                Scope(const Op & _op, const void* list, dllcnt_t size,
+                        std::uint64_t first = 0, std::uint64_t second = 0)
+                {
+                    if (enabled())
+                        begin(_op, list, size, first, second);
+                }
+                ~Scope()
+                {
+                    if (op)
+                        end();
+                }
+                Scope(const Scope &) = delete;
+                Scope & operator=(const Scope &) = delete;
+
+            private:
+                void begin(const Op & _op, const void* _list, dllcnt_t _size,
+                        std::uint64_t first, std::uint64_t second);
+                void end();
+
+                // Null when this call is not recorded
+                const Op* op{nullptr};
+                const void* list;
+                dllcnt_t size;
+                std::uint64_t args[2];
+                std::uint64_t start;
+        };
+
+    private:
+        static inline std::atomic<bool> on{false};
+};
+
+#endif  /* __DLL_TRACE_H_ */
@@ -0,0 +1,90 @@
+/*
+ * Filename:		dll_views.h
+ *
+ * Author:			Santiago Pagola
+ * Brief:			Lazy, composable views over a Doubly Linked List and a
+ to<DoublyLinkedList>() step to materialize them.
+ * Last modified:	mån 19 okt 2026 17:24:08 CEST
+*/
+
+#ifndef __DLL_VIEWS_H_
+#define __DLL_VIEWS_H_
+
+#include <cstddef>
+#include <ranges>
+#include <utility>
+
+#include "dll.h"
+
+// A list is a sized bidirectional std::ranges range, so std::views adaptors
+// apply to it as they are. Views only hold iterators into the list: they
+// copy nothing and allocate nothing, and elements are computed as they are
+// iterated. Like iterators, views are invalidated when the elements they
+// stand on are removed or the list is compacted.
+//
+//     auto view = list | dll::views::filter(isOdd) | dll::views::reverse
+//                      | dll::views::slice(1, 4);
+//     DoublyLinkedList copy = view | dll::to<DoublyLinkedList>();
+namespace dll
+{
+    namespace views
+    {
+        using std::views::all;
+        using std::views::filter;
+        using std::views::transform;
+        using std::views::reverse;
+        using std::views::take;
+        using std::views::drop;
+
+        // Elements at positions [from, to), clamped to the end. Reaching
+        // `from` walks the list, once: the view caches where it begins.
+        inline constexpr auto slice = [](dllcnt_t from, dllcnt_t to)
+        {
+            const dllcnt_t count = to > from ? to - from : 0;
+            return std::views::drop(static_cast<std::ptrdiff_t>(from))
+                | std::views::take(static_cast<std::ptrdiff_t>(count));
+        };
+    }
+
+    namespace detail
+    {
+        template <typename Container>
+        struct To
+        {
+            template <std::ranges::input_range Range>
+            friend Container operator|(Range && range, To)
+            {
+                Container out;
+                if constexpr (requires { out.appendRange(range); })
+                {
+                    out.appendRange(std::forward<Range>(range));
+                }
+                else
+                {
+                    for (auto && value : range)
+                    {
+                        out.push_back(value);
+                    }
+                }
+                return out;
+            }
+        };
+    }
+
+    // Materialize a range into a new container, the last step of a
+    // pipeline: view | dll::to<DoublyLinkedList>(), or dll::to<...>(view).
+    // A list gets all its nodes in one slab.
+    template <typename Container>
+    constexpr detail::To<Container> to()
+    {
+        return {};
+    }
+
+    template <typename Container, std::ranges::input_range Range>
+    Container to(Range && range)
+    {
+        return std::forward<Range>(range) | detail::To<Container>{};
+    }
+}
+
+#endif  /* __DLL_VIEWS_H_ */
@@ -1,11 +1,47 @@
 #include <iostream>
 #include <ctime>
 #include <cstdlib>
+#include <cassert>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <numeric>
+#include <ranges>
+#include <sstream>
+#include <thread>
+#include <csignal>
+
+#include <sys/resource.h>
+#include <unistd.h>
 
 #include "dll.h"
+#include "dll_intrusive.h"
+#include "dll_async.h"
+#include "dll_lru.h"
+#include "dll_paged.h"
+#include "dll_sorted.h"
+#include "dll_trace.h"
+#include "dll_views.h"
 
 using namespace std;
 
+// Sits on two lists: one through its base hook, one through a member hook
+struct Job : public IntrusiveListHook<>
+{
+    explicit Job(int _id) : id{_id} {}
+    int id;
+    IntrusiveListHook<> urgentHook;
+};
+
+// Pops `count` elements, adding them up into `sum`
+static AsyncTask consume(AsyncDoublyLinkedList & list, int count, int & sum)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        sum += co_await list.pop();
+    }
+}
+
 int main(int argc, char* argv[])
 {
     DoublyLinkedList list;
@@ -120,5 +156,551 @@ int main(int argc, char* argv[])
     DoublyLinkedList result {dividers / divisors};
     cout << "New result = " << result << " with size: " << result.size() << endl; 
 
+    // Iterators: mutation in place, reverse traversal and std algorithms
+    static_assert(std::ranges::bidirectional_range<DoublyLinkedList>);
+    DoublyLinkedList iterated{initializer_list<int>{5,3,9,1}};
+    for (int & value : iterated)
+    {
+        value *= 10;
+    }
+    cout << "Multiplied in place: " << iterated << endl;
+    assert(iterated.toString() == "[50,30,90,10]");
+    assert(std::accumulate(iterated.begin(), iterated.end(), 0) == 180);
+    assert(*std::ranges::max_element(iterated) == 90);
+    assert(std::ranges::find(iterated, 30) != iterated.end());
+    assert(std::ranges::find(iterated, 31) == iterated.end());
+    std::ranges::replace(iterated, 90, 91);
+    assert(*iterated.rbegin() == 10);
+    assert(*std::next(iterated.rbegin()) == 91);
+    auto post = iterated.begin();
+    assert(*post++ == 50 and *post == 30);
+    assert(*post-- == 30 and *post == 50);
+    DoublyLinkedList::const_iterator cit = iterated.begin();
+    assert(cit == iterated.cbegin());
+
+    // Intrusive lists: no allocation, O(1) removal from the object itself
+    Job jobs[] = {Job{1}, Job{2}, Job{3}};
+    IntrusiveList<Job> queue;
+    IntrusiveMemberList<Job, void, &Job::urgentHook> urgent;
+    for (Job & job : jobs)
+    {
+        queue.append(job);
+    }
+    urgent.append(jobs[2]);
+    urgent.prepend(jobs[0]);
+    assert(queue.count() == 3 and urgent.count() == 2);
+    assert(urgent.first().id == 1 and urgent.last().id == 3);
+    queue.remove(jobs[1]);
+    assert(not jobs[1].isLinked() and jobs[2].isLinked());
+    queue.moveToFront(jobs[2]);
+    assert(queue.first().id == 3 and queue.last().id == 1);
+    int jobSum = 0;
+    for (const Job & job : urgent)
+    {
+        jobSum += job.id;
+    }
+    assert(jobSum == 4);
+    urgent.clear();
+    assert(urgent.isEmpty() and not jobs[0].urgentHook.isLinked());
+    queue.clear();
+    // The ends of an empty list are its sentinel, never handed out as a Job
+    const std::function<void()> onEmpty[] = {
+        [&queue] { queue.first(); },
+        [&queue] { queue.last(); },
+        [&queue] { queue.removeFirst(); },
+        [&queue] { queue.removeLast(); },
+    };
+    for (const auto & operation : onEmpty)
+    {
+        bool emptyThrew = false;
+        try
+        {
+            operation();
+        }
+        catch (const std::out_of_range &)
+        {
+            emptyThrew = true;
+        }
+        assert(emptyThrew and queue.isEmpty());
+    }
+
+    // Coroutines: consumers suspend on an empty list until append() feeds them
+    LocalExecutor executor;
+    AsyncDoublyLinkedList asyncList{executor};
+    asyncList.append(1);
+    int sumA = 0, sumB = 0;
+    consume(asyncList, 2, sumA);
+    consume(asyncList, 2, sumB);
+    assert(sumA == 1 and asyncList.waiting() == 2);
+    asyncList.append(10);
+    asyncList.append(100);
+    // Nothing resumes until the executor runs
+    assert(sumA == 1 and sumB == 0);
+    executor.run();
+    assert(sumA == 11 and sumB == 100 and asyncList.waiting() == 1);
+    asyncList.append(1000);
+    asyncList.append(5);
+    executor.run();
+    assert(sumB == 1100 and asyncList.count() == 1 and executor.isIdle());
+
+    DoublyLinkedList streamed{initializer_list<int>{4,5,6}};
+    int position = 0;
+    for (int value : elements(streamed))
+    {
+        assert(value == streamed.at(position++));
+    }
+    assert(position == 3);
+    auto reversed = reverseElements(streamed);
+    assert(*reversed.begin() == 6);
+
+    // LRU cache: one shard makes the eviction order fully predictable
+    ShardedLruCache<int, string> cache{2, 1};
+    cache.put(1, "one");
+    cache.put(2, "two");
+    assert(cache.get(1).value() == "one");
+    cache.put(3, "three");
+    assert(not cache.get(2).has_value());
+    assert(cache.touch(1) and not cache.touch(2));
+    cache.put(4, "four");
+    assert(cache.get(1).has_value() and not cache.get(3).has_value());
+    cache.put(1, "uno");
+    assert(cache.get(1).value() == "uno" and cache.size() == 2);
+    auto stats = cache.stats();
+    assert(stats.hits == 3 and stats.misses == 2);
+    assert(stats.insertions == 4 and stats.evictions == 2);
+    assert(cache.erase(4) and not cache.erase(4) and cache.size() == 1);
+    ShardedLruCache<int, int> sharded{1000, 4};
+    for (int key = 0; key < 5000; ++key)
+    {
+        sharded.put(key, key);
+    }
+    assert(sharded.size() <= 1000 and sharded.stats().evictions >= 4000);
+    assert(sharded.get(4999).value() == 4999);
+
+    // Aggregates: same answers with and without the augmented mode
+    DoublyLinkedList tracked{initializer_list<int>{4,-3,12,7}};
+    assert(tracked.sum() == 20 and tracked.min() == -3 and tracked.max() == 12);
+    tracked.enableAggregates();
+    tracked.append(20);
+    tracked.prepend(-8);
+    tracked.insertAt(0, 3);
+    assert(tracked.sum() == 32 and tracked.min() == -8 and tracked.max() == 20);
+    tracked.removeFirst();
+    tracked.removeLast();
+    tracked.removeAt(3);
+    // [4,-3,0,7]
+    assert(tracked.sum() == 8 and tracked.min() == -3 and tracked.max() == 7);
+    tracked.setAt(1, 9);
+    assert(tracked.min() == 0 and tracked.max() == 9 and tracked.aggregates().count == 4);
+    auto window = tracked.aggregates(1, 2);
+    assert(window.sum == 9 and window.min == 0 and window.max == 9 and window.count == 2);
+    DoublyLinkedList trackedCopy{tracked};
+    assert(trackedCopy.aggregatesEnabled() and trackedCopy.sum() == 20);
+    tracked.clear();
+    tracked.append(5);
+    assert(tracked.sum() == 5 and tracked.min() == 5 and tracked.max() == 5);
+
+    // Compaction: nodes end up in one block, in list order
+    DoublyLinkedList churned;
+    for (int i = 0; i < 64; ++i)
+    {
+        churned.append(i);
+        churned.prepend(-i);
+    }
+    for (int i = 0; i < 32; ++i)
+    {
+        churned.removeAt(i);
+    }
+    const std::string beforeCompaction = churned.toString();
+    churned.compact();
+    assert(churned.toString() == beforeCompaction and churned.fragmentation() == 0.0);
+    // Slab nodes can still be removed and mixed with new ones
+    churned.removeFirst();
+    churned.removeAt(10);
+    churned.insertAt(1000, 5);
+    churned.append(2000);
+    assert(churned.count() == 96 and churned.at(5) == 1000);
+    churned.compact();
+    assert(churned.count() == 96 and *churned.rbegin() == 2000);
+    DoublyLinkedList autoCompacted;
+    autoCompacted.setAutoCompact(0.5);
+    for (int i = 0; i < 200; ++i)
+    {
+        autoCompacted.prepend(i);
+        autoCompacted.maybeCompact();
+    }
+    // Auto-compaction kept fragmentation below 0.9: without it, every link
+    // of a prepended list would point backwards
+    assert(autoCompacted.fragmentation() < 0.9 and autoCompacted.at(0) == 199);
+    // 64-bit positions: a wrapped-around "negative" index is out of range
+    static_assert(sizeof(dllcnt_t) == 8);
+    bool threw = false;
+    try
+    {
+        autoCompacted.at(static_cast<dllcnt_t>(-1));
+    }
+    catch (const std::out_of_range &)
+    {
+        threw = true;
+    }
+    assert(threw);
+    // Paged list: 4 values per page, at most 2 pages in memory
+    PagedDoublyLinkedList::Options pagedOptions;
+    pagedOptions.pageElements = 4;
+    pagedOptions.maxResidentPages = 2;
+    PagedDoublyLinkedList paged{pagedOptions};
+    DoublyLinkedList mirror;
+    for (int i = 0; i < 40; ++i)
+    {
+        paged.append(i);
+        mirror.append(i);
+    }
+    paged.prepend(-1);
+    mirror.prepend(-1);
+    paged.insertAt(100, 17);
+    mirror.insertAt(100, 17);
+    paged.removeAt(30);
+    mirror.removeAt(30);
+    paged.removeLast();
+    mirror.removeLast();
+    paged.setAt(2, 222);
+    mirror.setAt(2, 222);
+    assert(paged.toString() == mirror.toString() and paged.count() == mirror.count());
+    assert(paged.at(17) == 100 and paged.at(paged.count() - 1) == 38);
+    auto pagedStats = paged.stats();
+    assert(pagedStats.residentPages <= 2 and pagedStats.pageWrites > 0 and pagedStats.pageReads > 0);
+    paged.clear();
+    assert(paged.isEmpty() and paged.toString() == "[]");
+    // A spill cut short by the file size limit throws, and the page it was
+    // for stays in memory: the list remains whole and usable
+    {
+        rlimit saved;
+        getrlimit(RLIMIT_FSIZE, &saved);
+        rlimit limited = saved;
+        limited.rlim_cur = 6 * sizeof(int);
+        std::signal(SIGXFSZ, SIG_IGN);
+        PagedDoublyLinkedList spilling{pagedOptions};
+        bool spillFailed = false;
+        setrlimit(RLIMIT_FSIZE, &limited);
+        try
+        {
+            for (int i = 0; i < 16; ++i)
+            {
+                spilling.append(i);
+            }
+        }
+        catch (const std::system_error &)
+        {
+            spillFailed = true;
+        }
+        setrlimit(RLIMIT_FSIZE, &saved);
+        std::signal(SIGXFSZ, SIG_DFL);
+        assert(spillFailed and spilling.count() == 12);
+        spilling.append(12);
+        assert(spilling.toString() == "[0,1,2,3,4,5,6,7,8,9,10,11,12]");
+    }
+
+    // Journal: a replica fed with deltas follows the primary
+    DoublyLinkedList primary{1, 2, 3};
+    DoublyLinkedList replica;
+    primary.enableJournal();
+    replica.replay(primary.takeDelta());
+    assert(replica.toString() == "[1,2,3]");
+    for (int i = 0; i < 20; ++i)
+    {
+        primary.append(i);
+    }
+    replica.replay(primary.takeDelta());
+    primary.append(-70000);
+    primary.insertAt(9, 1);
+    primary.removeFirst();
+    primary.swap(0, 2);
+    primary.setAt(1, -5);
+    primary.removeLast();
+    auto delta = primary.takeDelta();
+    assert(delta.size() < primary.snapshot().size());
+    replica.replay(delta);
+    assert(replica.toString() == primary.toString());
+    assert(primary.takeDelta().empty());
+    primary.clear();
+    primary.prepend(4);
+    replica.replay(primary.takeDelta());
+    assert(replica.toString() == "[4]");
+    threw = false;
+    try
+    {
+        replica.replay(std::string(1, '\x7f'));
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    assert(threw);
+
+    // Sorted lists: merge relinks nodes, set operations build new lists
+    DoublyLinkedList odds{1, 3, 5, 7};
+    DoublyLinkedList smalls{1, 2, 3, 4};
+    assert(odds.setUnion(smalls).toString() == "[1,2,3,4,5,7]");
+    assert(odds.setIntersection(smalls).toString() == "[1,3]");
+    assert(odds.setDifference(smalls).toString() == "[5,7]");
+    assert(odds.includes(DoublyLinkedList{3, 7}) and not odds.includes(smalls));
+    smalls.compact();
+    odds.enableAggregates();
+    odds.merge(smalls);
+    assert(odds.toString() == "[1,1,2,3,3,4,5,7]" and smalls.isEmpty());
+    assert(odds.sum() == 26 and odds.count() == 8);
+    odds.removeAt(3);
+    assert(odds.at(3) == 3 and odds.count() == 7);
+
+    // Handles survive unrelated changes, and are replicated by position
+    DoublyLinkedList handled{10, 20};
+    DoublyLinkedList handledReplica;
+    handled.enableJournal();
+    handledReplica.replay(handled.takeDelta());
+    auto thirty = handled.append(30);
+    auto five = handled.prepend(5);
+    auto fifteen = handled.insertAt(15, 2);
+    handled.removeAt(1);
+    handled.insertAfter(thirty, 40);
+    handled.insertBefore(handled.end(), 50);
+    handled.insertBefore(fifteen, 12);
+    handled.moveToBack(five);
+    handled.moveToFront(thirty);
+    assert(handled.toString() == "[30,12,15,20,40,50,5]");
+    assert(*handled.erase(fifteen) == 20 and *five == 5 and *thirty == 30);
+    handledReplica.replay(handled.takeDelta());
+    assert(handledReplica.toString() == "[30,12,20,40,50,5]");
+    threw = false;
+    try
+    {
+        handled.erase(handled.end());
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    assert(threw);
+    // Auto-compaction never moves nodes behind a handle's back: prepending
+    // past the threshold leaves them in place until maybeCompact()
+    DoublyLinkedList handledCompacted;
+    handledCompacted.setAutoCompact(0.1);
+    auto kept = handledCompacted.append(7);
+    for (int i = 0; i < 100; ++i)
+    {
+        handledCompacted.prepend(i);
+    }
+    assert(handledCompacted.fragmentation() > 0.1 and *kept == 7);
+    assert(handledCompacted.erase(kept) == handledCompacted.end());
+    assert(handledCompacted.maybeCompact() and handledCompacted.fragmentation() == 0.0);
+    assert(not handledCompacted.maybeCompact() and handledCompacted.count() == 100);
+
+    // Parsing: the inverse of toString(), also from streams and descriptors
+    DoublyLinkedList parsed = DoublyLinkedList::fromString(" [ 3,-40 , 2147483647,-2147483648 ] ");
+    assert(parsed.toString() == "[3,-40,2147483647,-2147483648]");
+    assert(DoublyLinkedList::fromString("[]").isEmpty());
+    for (const char* bad : {"", "[", "[1,]", "[1 2]", "[+1]", "[2147483648]", "[1]x", "1,2"})
+    {
+        threw = false;
+        try
+        {
+            DoublyLinkedList::fromString(bad);
+        }
+        catch (const std::invalid_argument &)
+        {
+            threw = true;
+        }
+        assert(threw);
+    }
+    // Big enough to cut numbers at chunk boundaries
+    DoublyLinkedList big;
+    for (int i = 0; i < 50000; ++i)
+    {
+        big.append(i % 2 ? -i * 997 : i);
+    }
+    std::stringstream bigText;
+    bigText << big << "\n";
+    assert(DoublyLinkedList::fromStream(bigText).toString() == big.toString());
+    int fds[2];
+    assert(pipe(fds) == 0);
+    assert(write(fds[1], "[7, 8,\n9]\n", 10) == 10);
+    close(fds[1]);
+    assert(DoublyLinkedList::fromFd(fds[0]).toString() == "[7,8,9]");
+    close(fds[0]);
+    std::istringstream listsText{"[1,2] [3]  [4,x] [5]"};
+    DoublyLinkedList first, second, third;
+    listsText >> first >> second;
+    assert(first.toString() == "[1,2]" and second.toString() == "[3]");
+    assert(not (listsText >> third) and third.isEmpty());
+
+    // Skip list: ordered inserts and lookups, rank queries through lane widths
+    SortedDoublyLinkedList sorted{5, 1, 4};
+    DoublyLinkedList sortedMirror{1, 4, 5};
+    for (int i = 0; i < 500; ++i)
+    {
+        const int value = (i * 7919) % 103;
+        sorted.insertSorted(value);
+        auto pos = std::upper_bound(sortedMirror.begin(), sortedMirror.end(), value);
+        if (pos == sortedMirror.end())
+        {
+            sortedMirror.append(value);
+        }
+        else
+        {
+            sortedMirror.insertAt(value, std::distance(sortedMirror.begin(), pos));
+        }
+    }
+    for (int i = 0; i < 300; i += 3)
+    {
+        auto pos = std::lower_bound(sortedMirror.begin(), sortedMirror.end(), i % 103);
+        const bool found = pos != sortedMirror.end() and *pos == i % 103;
+        assert(sorted.erase(i % 103) == found);
+        if (found)
+        {
+            sortedMirror.removeAt(std::distance(sortedMirror.begin(), pos));
+        }
+    }
+    assert(sorted.toString() == sortedMirror.toString() and sorted.count() == sortedMirror.count());
+    assert(std::equal(sorted.rbegin(), sorted.rend(), sortedMirror.rbegin()));
+    for (dllcnt_t i = 0; i < sorted.count(); i += 17)
+    {
+        assert(sorted.at(i) == sortedMirror.at(i));
+        assert(sorted.rank(sorted.at(i)) == static_cast<dllcnt_t>(
+                    std::distance(sorted.begin(), sorted.lower_bound(sorted.at(i)))));
+    }
+    assert(*sorted.lower_bound(50) >= 50 and *std::prev(sorted.upper_bound(50)) <= 50);
+    assert(sorted.upper_bound(1000) == sorted.end() and not sorted.erase(1000));
+    sorted.clear();
+    assert(sorted.isEmpty() and sorted.rank(3) == 0 and sorted.toString() == "[]");
+
+    // Tracing: outermost calls only, dumped as Chrome trace events
+    DoublyLinkedList traced{1, 2, 3};
+    DoublyLinkedList zero{0};
+    DllTrace::enable();
+    traced.swap(0, 2);
+    traced.merge(zero);
+    DllTrace::disable();
+    traced.append(4);
+    std::ostringstream traceJson;
+    DllTrace::dump(traceJson);
+    const std::string trace = traceJson.str();
+    assert(trace.starts_with("{\"traceEvents\":["));
+    assert(trace.find("\"name\":\"DoublyLinkedList::swap\"") != std::string::npos);
+    assert(trace.find("\"size\":3,\"pos1\":0,\"pos2\":2}") != std::string::npos);
+    assert(trace.find("DoublyLinkedList::merge") != std::string::npos);
+    assert(trace.find("DoublyLinkedList::append") == std::string::npos);
+    DllTrace::clear();
+    // Threads coming and going take over the rings of finished threads: only
+    // the last keptRings threads' events remain
+    DllTrace::enable();
+    for (std::size_t i = 0; i < 3 * DllTrace::keptRings; ++i)
+    {
+        std::thread([] { DoublyLinkedList{}.append(1); }).join();
+    }
+    DllTrace::disable();
+    std::ostringstream workersJson;
+    DllTrace::dump(workersJson);
+    const std::string workers = workersJson.str();
+    // An append and the destructor's clear per thread, a line each
+    assert(static_cast<std::size_t>(std::count(workers.begin(), workers.end(), '\n')) == 2 * DllTrace::keptRings + 2);
+    DllTrace::clear();
+
+    // Memory accounting: per list, and over all live lists
+    std::size_t listsBefore = 0;
+    const auto before = DoublyLinkedList::totalMemoryUsage(&listsBefore);
+    {
+        DoublyLinkedList sized{1, 2, 3, 4, 5, 6, 7, 8};
+        const auto usage = sized.memoryUsage();
+        assert(usage.elements == 8 and usage.payloadBytes == 8 * sizeof(int));
+        assert(usage.totalBytes == usage.payloadBytes + usage.linkBytes + usage.sentinelBytes +
+                usage.auxiliaryBytes + usage.slackBytes);
+        std::size_t listsAfter = 0;
+        const auto after = DoublyLinkedList::totalMemoryUsage(&listsAfter);
+        assert(listsAfter == listsBefore + 1 and after.totalBytes == before.totalBytes + usage.totalBytes);
+        // Compaction trades per-node slack for one block; removed nodes stay in it
+        sized.compact();
+        const auto compacted = sized.memoryUsage();
+        sized.removeFirst();
+        assert(sized.memoryUsage().linkBytes == usage.linkBytes * 7 / 8);
+        assert(sized.memoryUsage().totalBytes == compacted.totalBytes);
+    }
+    // Assignments hand the aggregates over with the content, and their bytes
+    {
+        DoublyLinkedList source{4, 5, 6};
+        source.enableAggregates();
+        DoublyLinkedList copied{1};
+        copied = source;
+        const DoublyLinkedList copiedFresh(copied);
+        assert(copied.memoryUsage().auxiliaryBytes == copiedFresh.memoryUsage().auxiliaryBytes);
+        assert(copied.memoryUsage().totalBytes == copiedFresh.memoryUsage().totalBytes);
+        DoublyLinkedList moved{1, 2};
+        moved = std::move(source);
+        const DoublyLinkedList movedFresh(moved);
+        assert(moved.memoryUsage().auxiliaryBytes == movedFresh.memoryUsage().auxiliaryBytes);
+        assert(moved.memoryUsage().totalBytes == movedFresh.memoryUsage().totalBytes);
+        assert(source.memoryUsage().auxiliaryBytes == DoublyLinkedList(source).memoryUsage().auxiliaryBytes);
+    }
+    assert(DoublyLinkedList::totalMemoryUsage().totalBytes == before.totalBytes);
+    // Accounting reads counters only: safe while other threads modify,
+    // compact and clear their lists
+    {
+        std::atomic<bool> churned{false};
+        std::thread churner([&churned] {
+            DoublyLinkedList churning;
+            for (int round = 0; round < 200; ++round)
+            {
+                for (int i = 0; i < 100; ++i)
+                {
+                    churning.prepend(i);
+                }
+                churning.compact();
+                churning.removeAt(50);
+                churning.clear();
+            }
+            churned = true;
+        });
+        while (not churned)
+        {
+            assert(DoublyLinkedList::totalMemoryUsage().totalBytes >= before.totalBytes);
+        }
+        churner.join();
+    }
+    // Lists registered by other threads, one destroyed here, are counted too
+    {
+        std::vector<DoublyLinkedList*> created(4);
+        std::vector<std::thread> creators;
+        for (auto & list : created)
+        {
+            creators.emplace_back([&list] { list = new DoublyLinkedList{1, 2, 3}; });
+        }
+        for (auto & creator : creators)
+        {
+            creator.join();
+        }
+        std::size_t listsNow = 0;
+        assert(DoublyLinkedList::totalMemoryUsage(&listsNow).elements == before.elements + 12);
+        assert(listsNow == listsBefore + 4);
+        for (DoublyLinkedList* list : created)
+        {
+            delete list;
+        }
+    }
+    assert(DoublyLinkedList::totalMemoryUsage().totalBytes == before.totalBytes);
+
+    // Lazy views: nothing is copied until to<DoublyLinkedList>()
+    {
+        DoublyLinkedList source{1, 2, 3, 4, 5, 6, 7, 8, 9};
+        auto odd = source | dll::views::filter([](int value) { return value % 2; });
+        auto view = odd | dll::views::reverse | dll::views::transform([](int value) { return value * 10; });
+        source.setAt(4, 60);
+        assert(std::ranges::equal(view, std::vector<int>{90, 70, 30, 10}));
+        assert((source | dll::views::slice(2, 5) | dll::to<DoublyLinkedList>()).toString() == "[3,4,60]");
+        assert((source | dll::views::slice(7, 100) | dll::to<DoublyLinkedList>()).toString() == "[8,9]");
+        assert(dll::to<DoublyLinkedList>(source | dll::views::slice(5, 2)).isEmpty());
+        const auto taken = dll::to<std::vector<int>>(source | dll::views::reverse | dll::views::take(2));
+        assert((taken == std::vector<int>{9, 8}));
+        source.appendRange(source | dll::views::drop(7));
+        assert(source.size() == 11 and source.at(10) == 9);
+    }
+
     return 0;
 }
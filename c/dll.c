@@ -1,29 +1,76 @@
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "dll.h"
+#include "dll_internal.h"
 
-#define abort_unless(expr) \
-    if (!(expr)) {\
-        fprintf(stderr, "Aborting since condition \"%s\" wan't met.\n", #expr);\
-        abort();\
+/*
+ * Every live list, for dll_memory_usage_total(). A list goes to the shard of the thread creating it, so that
+ * threads creating and destroying lists at the same time seldom share a lock; queries walk all shards.
+ */
+#define DLL_REGISTRY_SHARDS 16
+
+typedef struct {
+    alignas(64) pthread_mutex_t lock; // Aligned so that two shards' locks never share a cache line
+    dll_ilist_t                 lists;
+} dll_registry_shard_t;
+
+static dll_registry_shard_t dll_registry[DLL_REGISTRY_SHARDS];
+static pthread_once_t       dll_registry_once = PTHREAD_ONCE_INIT;
+static atomic_uint          dll_registry_threads;
+// Shard of the calling thread plus one, 0 until its first list
+static _Thread_local unsigned dll_registry_thread_shard;
+
+static void
+dll_registry_init(void)
+{
+    for (size_t i = 0; i < DLL_REGISTRY_SHARDS; ++i) {
+        pthread_mutex_init(&dll_registry[i].lock, NULL);
+        dll_ilist_init(&dll_registry[i].lists);
     }
+}
 
-struct dll_node_type {
-    struct dll_node_type* next;
-    struct dll_node_type* prev;
-    void*                 data;
-};
+/* Register @p list in the calling thread's shard. */
+static void
+dll_register(dll_t* list)
+{
+    pthread_once(&dll_registry_once, dll_registry_init);
+    if (!dll_registry_thread_shard) {
+        dll_registry_thread_shard =
+            1 + atomic_fetch_add_explicit(&dll_registry_threads, 1, memory_order_relaxed) % DLL_REGISTRY_SHARDS;
+    }
+    list->registry_shard = dll_registry_thread_shard - 1;
 
-struct dll_type {
-    dll_node_t* head;
-    dll_node_t* tail;
-    size_t      count;
-};
+    dll_registry_shard_t* shard = &dll_registry[list->registry_shard];
+    pthread_mutex_lock(&shard->lock);
+    dll_ilist_append(&shard->lists, &list->registry_hook);
+    pthread_mutex_unlock(&shard->lock);
+}
 
-dll_t*
-dll_create(void)
+static void*
+dll_malloc(void* ctx, const size_t size)
+{
+    (void)ctx;
+    return malloc(size);
+}
+
+static void
+dll_free(void* ctx, void* ptr)
+{
+    (void)ctx;
+    free(ptr);
+}
+
+/*
+ * Build a list with all its fields set up but not yet registered: once
+ * dll_register() publishes it, other threads may read it at any time.
+ */
+static dll_t*
+dll_create_unregistered(const size_t elem_size, const dll_allocator_t* allocator)
 {
     // Create our list
     dll_t* list = malloc(sizeof *list);
@@ -42,16 +89,59 @@ dll_create(void)
     list->tail->prev = list->head; 
 
     // 0 elements at the beginning
-	list->count = 0;
+	dll_counter_set(list->count, 0);
+    // Lists of pointers, with nodes from malloc, by default
+    list->elem_size = elem_size;
+    if (allocator) {
+        list->allocator = *allocator;
+    } else {
+        list->allocator = (dll_allocator_t){
+            .alloc       = dll_malloc,
+            .free        = dll_free,
+            .free_chain  = NULL,
+            .usable_size = NULL,
+            .ctx         = NULL,
+        };
+    }
+
+    // No contiguous storage until dll_from_array_block()
+    list->node_block    = NULL;
+    list->payload_block = NULL;
+    dll_counter_set(list->block_size, 0);
+    dll_counter_set(list->block_live, 0);
+    dll_counter_set(list->block_elem, 0);
 
 	return list;
 }
 
+dll_t*
+dll_create(void)
+{
+    dll_t* list = dll_create_unregistered(0, NULL);
+    dll_register(list);
+    return list;
+}
+
+static void
+dll_release(dll_t* list, dll_free_fn_t fn, dll_free_batch_fn_t batch_fn);
+
+static void
+dll_unregister(dll_t* list)
+{
+    dll_registry_shard_t* shard = &dll_registry[list->registry_shard];
+    pthread_mutex_lock(&shard->lock);
+    dll_ilist_remove(&shard->lists, &list->registry_hook);
+    pthread_mutex_unlock(&shard->lock);
+}
+
 void
 dll_destroy(dll_t* list, dll_free_fn_t fn)
 {
+    DLL_TRACE("dll_destroy", list);
+
     // Empty the list
-	dll_empty(list, fn);
+	dll_release(list, fn, NULL);
+    dll_unregister(list);
 
     // Free special nodes and the actual list
     free(list->head);
@@ -59,6 +149,52 @@ dll_destroy(dll_t* list, dll_free_fn_t fn)
 	free(list);
 }
 
+void
+dll_destroy_batch(dll_t* list, dll_free_batch_fn_t fn)
+{
+    DLL_TRACE("dll_destroy_batch", list);
+
+	dll_release(list, NULL, fn);
+    dll_unregister(list);
+
+    free(list->head);
+    free(list->tail);
+	free(list);
+}
+
+dll_t*
+dll_create_typed(const size_t elem_size)
+{
+    abort_unless(elem_size > 0);
+
+    return dll_create_with_allocator(elem_size, NULL);
+}
+
+dll_t*
+dll_create_with_allocator(const size_t elem_size, const dll_allocator_t* allocator)
+{
+    abort_unless(!allocator || allocator->alloc);
+
+    dll_t* list = dll_create_unregistered(elem_size, allocator);
+    dll_register(list);
+    return list;
+}
+
+size_t
+dll_elem_size(const dll_t* list)
+{
+    return list->elem_size;
+}
+
+/* Whether @p node lives in the list's node block (and its data in the payload block). */
+static bool
+dll_in_block(const dll_t* list, const dll_node_t* node)
+{
+    const uintptr_t first = (uintptr_t)list->node_block;
+    const uintptr_t addr  = (uintptr_t)node;
+    return addr >= first && addr < first + list->block_size * sizeof *node;
+}
+
 static dll_node_t*
 dll_delete(dll_t* list, dll_node_t* node, dll_free_fn_t fn)
 {
@@ -89,32 +225,100 @@ dll_delete(dll_t* list, dll_node_t* node, dll_free_fn_t fn)
     // Update the output node
     out = node->next;
 
-    // Free stuff
-    if (fn) {
-        fn(node->data);
+    // Free stuff; block nodes and their payloads go away with the blocks
+    if (dll_in_block(list, node)) {
+        dll_counter_sub(list->block_live, 1);
+    }
+    else {
+        if (fn) {
+            fn(node->data);
+        }
+        dll_node_free(list, node);
     }
-	free(node);
 
     // Decrease count
-    list->count--;
+    dll_counter_sub(list->count, 1);
     return out;
 }
 
-void
-dll_empty(dll_t* list, dll_free_fn_t fn)
+/*
+ * Release every node and element at once. Nothing is relinked since all of it goes away: a single pass frees
+ * elements (through fn, or batch_fn DLL_FREE_BATCH elements at a time) and nodes, and is skipped altogether
+ * when there is nothing to free one by one. Block nodes come back with their blocks, arena nodes with their
+ * arena, and chains of pool nodes go back to their pool in one splice.
+ */
+static void
+dll_release(dll_t* list, dll_free_fn_t fn, dll_free_batch_fn_t batch_fn)
 {
-    dll_node_t* current = list->head->next;
-    while (current != list->tail) {
-        current = dll_delete(list, current, fn);
-	}
-    abort_unless(list->count == 0);
+    const dll_allocator_t* allocator = &list->allocator;
+    const bool             splice    = allocator->free_chain && list->block_live == 0;
+    const bool             per_node  = allocator->free && !splice;
+
+    if (list->count > list->block_live && (fn || batch_fn || per_node)) {
+        void*            batch[DLL_FREE_BATCH];
+        size_t           batched = 0;
+        dll_node_t*      current = list->head->next;
+        dll_prefetcher_t pf;
+
+        dll_prefetcher_init(&pf, current, list->tail);
+        while (current != list->tail) {
+            dll_prefetcher_step(&pf);
+            dll_node_t* next = current->next;
+            if (!dll_in_block(list, current)) {
+                if (fn) {
+                    fn(current->data);
+                }
+                else if (batch_fn) {
+                    batch[batched++] = current->data;
+                    if (batched == DLL_FREE_BATCH) {
+                        batch_fn(batch, batched);
+                        batched = 0;
+                    }
+                }
+                if (per_node) {
+                    allocator->free(allocator->ctx, current);
+                }
+            }
+            current = next;
+        }
+        if (batched) {
+            batch_fn(batch, batched);
+        }
+    }
+    if (splice && list->count) {
+        allocator->free_chain(allocator->ctx, list->head->next, list->tail->prev);
+    }
+
+    free(list->node_block);
+    free(list->payload_block);
+    list->node_block    = NULL;
+    list->payload_block = NULL;
+    dll_counter_set(list->block_size, 0);
+    dll_counter_set(list->block_live, 0);
+    dll_counter_set(list->block_elem, 0);
 
     // Head points to tail
     list->head->next = list->tail; 
     // Tail points back to head
     list->tail->prev = list->head; 
     // And reset the count
-	list->count = 0;
+	dll_counter_set(list->count, 0);
+}
+
+void
+dll_empty(dll_t* list, dll_free_fn_t fn)
+{
+    DLL_TRACE("dll_empty", list);
+
+    dll_release(list, fn, NULL);
+}
+
+void
+dll_empty_batch(dll_t* list, dll_free_batch_fn_t fn)
+{
+    DLL_TRACE("dll_empty_batch", list);
+
+    dll_release(list, NULL, fn);
 }
 
 bool
@@ -130,10 +334,8 @@ dll_count(const dll_t* list)
 }
 
 static void
-dll_insert_after(dll_t* list, dll_node_t*node, void* data)
+dll_link_after(dll_t* list, dll_node_t* node, dll_node_t* new_node)
 {
-    dll_node_t* new_node = malloc(sizeof *new_node);
-
 	new_node->prev = node;
 	new_node->next = node->next;
 
@@ -144,17 +346,14 @@ dll_insert_after(dll_t* list, dll_node_t*node, void* data)
 		node->next->prev = new_node;
 	}
 
-	node->next     = new_node;
-    new_node->data = data;
+	node->next = new_node;
 
-	list->count++;
+	dll_counter_add(list->count, 1);
 }
 
 static void
-dll_insert_before(dll_t* list, dll_node_t*node, void* data)
+dll_link_before(dll_t* list, dll_node_t* node, dll_node_t* new_node)
 {
-    dll_node_t* new_node = malloc(sizeof *new_node);
-
 	new_node->prev = node->prev;
 	new_node->next = node;
 
@@ -164,22 +363,67 @@ dll_insert_before(dll_t* list, dll_node_t*node, void* data)
 	else {
 		node->prev->next = new_node;
 	}
-	node->prev     = new_node;
-    new_node->data = data;
+	node->prev = new_node;
 
-	list->count++;
+	dll_counter_add(list->count, 1);
 }
 
 void
 dll_insert_beginning(dll_t* list, void* data)
 {
-    dll_insert_before(list, list->head->next, data);
+    DLL_TRACE("dll_insert_beginning", list);
+
+    // Typed lists store copies: see dll_prepend_copy()
+    abort_unless(!list->elem_size);
+
+    dll_node_t* new_node = dll_node_alloc(list);
+    new_node->data       = data;
+    dll_link_before(list, list->head->next, new_node);
 }
 
 void
 dll_insert_end(dll_t* list, void* data)
 {
-    dll_insert_after(list, list->tail->prev, data);
+    DLL_TRACE("dll_insert_end", list);
+
+    // Typed lists store copies: see dll_append_copy()
+    abort_unless(!list->elem_size);
+
+    dll_node_t* new_node = dll_node_alloc(list);
+    new_node->data       = data;
+    dll_link_after(list, list->tail->prev, new_node);
+}
+
+/* A node of a typed list holding a copy of @p elem. */
+static dll_node_t*
+dll_node_copy(const dll_t* list, const void* elem)
+{
+    abort_unless(list->elem_size);
+
+    dll_node_t* new_node = dll_node_alloc(list);
+    memcpy(new_node->payload, elem, list->elem_size);
+    new_node->data = new_node->payload;
+    return new_node;
+}
+
+void*
+dll_prepend_copy(dll_t* list, const void* elem)
+{
+    DLL_TRACE("dll_prepend_copy", list);
+
+    dll_node_t* new_node = dll_node_copy(list, elem);
+    dll_link_before(list, list->head->next, new_node);
+    return new_node->payload;
+}
+
+void*
+dll_append_copy(dll_t* list, const void* elem)
+{
+    DLL_TRACE("dll_append_copy", list);
+
+    dll_node_t* new_node = dll_node_copy(list, elem);
+    dll_link_after(list, list->tail->prev, new_node);
+    return new_node->payload;
 }
 
 static dll_node_t*
@@ -189,20 +433,40 @@ dll_peek_node_at(const dll_t* list, const size_t index)
         return NULL;
     }
 
-    dll_node_t* node = list->head->next;
-    size_t count = 0;
-    while (node != list->tail) {
-        if (count++ == index) {
-            return node;
+    // Walk from whichever end is closer
+    dll_node_t* node = NULL;
+    if (index < list->count - index) {
+        node = list->head->next;
+        for (size_t i = 0; i < index; ++i) {
+            node = node->next;
         }
-        node = node->next;
     }
-    return NULL;
+    else {
+        node = list->tail->prev;
+        for (size_t i = list->count - 1; i > index; --i) {
+            node = node->prev;
+        }
+    }
+    return node;
+}
+
+void*
+dll_peek_first(const dll_t* list)
+{
+    return list->count ? list->head->next->data : NULL;
+}
+
+void*
+dll_peek_last(const dll_t* list)
+{
+    return list->count ? list->tail->prev->data : NULL;
 }
 
 void*
 dll_peek_at(const dll_t* list, const size_t index)
 {
+    DLL_TRACE_ARGS("dll_peek_at", list, "index", index, NULL, 0);
+
     const dll_node_t* node = dll_peek_node_at(list, index);
 
     if (!node) {
@@ -212,29 +476,91 @@ dll_peek_at(const dll_t* list, const size_t index)
     return node->data;
 }
 
+/* Extract the data of a node known to be in the list. */
+static void*
+dll_extract_node(dll_t* list, dll_node_t* node)
+{
+    // The element of a typed list would go away with its node: see dll_extract_at_into()
+    abort_unless(!list->elem_size);
+
+    void* data = node->data;
+    dll_delete(list, node, NULL);
+    return data;
+}
+
 void*
 dll_extract_at(dll_t* list, const size_t index)
 {
+    DLL_TRACE_ARGS("dll_extract_at", list, "index", index, NULL, 0);
+
     dll_node_t* node = dll_peek_node_at(list, index);
 
     if (!node) {
         return NULL;
     }
 
-    void* data = node->data;
+    return dll_extract_node(list, node);
+}
+
+void*
+dll_extract_first(dll_t* list)
+{
+    DLL_TRACE("dll_extract_first", list);
+
+    return list->count ? dll_extract_node(list, list->head->next) : NULL;
+}
+
+void*
+dll_extract_last(dll_t* list)
+{
+    DLL_TRACE("dll_extract_last", list);
+
+    return list->count ? dll_extract_node(list, list->tail->prev) : NULL;
+}
+
+bool
+dll_extract_at_into(dll_t* list, const size_t index, void* out)
+{
+    DLL_TRACE_ARGS("dll_extract_at_into", list, "index", index, NULL, 0);
+
+    abort_unless(list->elem_size);
+
+    dll_node_t* node = dll_peek_node_at(list, index);
+
+    if (!node) {
+        return false;
+    }
+
+    memcpy(out, node->payload, list->elem_size);
     dll_delete(list, node, NULL);
 
-    return data;
+    return true;
+}
+
+/* Append the element of @p node (from a list of the same kind) to @p list: typed elements are copied. */
+static void
+dll_append_from(dll_t* list, const dll_node_t* node)
+{
+    if (list->elem_size)
+        dll_append_copy(list, node->payload);
+    else
+        dll_append(list, node->data);
 }
 
 dll_t*
 dll_clone(const dll_t* list)
 {
-    dll_t*      clone   = dll_create();
-    dll_node_t* current = list->head->next;
+    DLL_TRACE("dll_clone", list);
+
+    // Clones share the allocator; typed ones get their own copies of the elements
+    dll_t*           clone   = dll_create_with_allocator(list->elem_size, &list->allocator);
+    dll_node_t*      current = list->head->next;
+    dll_prefetcher_t pf;
 
+    dll_prefetcher_init(&pf, current, list->tail);
     while (current != list->tail) {
-        dll_append(clone, current->data);
+        dll_prefetcher_step(&pf);
+        dll_append_from(clone, current);
         current = current->next;
     }
     return clone;
@@ -243,11 +569,16 @@ dll_clone(const dll_t* list)
 dll_node_t*
 dll_find(const dll_t* list, dll_find_fn_t fn, void* arg)
 {
+    DLL_TRACE("dll_find", list);
+
     /* Searching function must be provided (otherwise, what's the point of this function? :)) */
     abort_unless(fn);
 
-    dll_node_t* current = list->head->next;
+    dll_node_t*      current = list->head->next;
+    dll_prefetcher_t pf;
+    dll_prefetcher_init(&pf, current, list->tail);
     while (current != list->tail) {
+        dll_prefetcher_step(&pf);
         if (fn(current->data, arg)) {
             return current;
         }
@@ -266,6 +597,8 @@ dll_node_peek(const dll_node_t* node)
 void
 dll_remove(dll_t* list, dll_node_t* node, dll_free_fn_t fn)
 {
+    DLL_TRACE("dll_remove", list);
+
     dll_delete(list, node, fn);
 }
 
@@ -330,6 +663,8 @@ dll_swap_nodes(dll_t* list, dll_node_t* node1, dll_node_t* node2)
 bool
 dll_swap(dll_t* list, const size_t index1, const size_t index2)
 {
+    DLL_TRACE_ARGS("dll_swap", list, "index1", index1, "index2", index2);
+
     if (index1 < 0 || index1 >= list->count || index2 < 0 || index2 >= list->count)
         return false;
 
@@ -344,17 +679,61 @@ dll_swap(dll_t* list, const size_t index1, const size_t index2)
         max = index1;
     }
 
-    return dll_swap_nodes(list, dll_peek_node_at(list, min), dll_peek_node_at(list, max));
+    // Find both nodes in one walk, taking the cheapest route: head to min then on to max, tail to max then
+    // back to min, or head to min and tail to max
+    const size_t from_head = max;
+    const size_t from_tail = list->count - 1 - min;
+    const size_t both_ends = min + (list->count - 1 - max);
+    dll_node_t*  node1     = NULL;
+    dll_node_t*  node2     = NULL;
+
+    if (from_head <= from_tail && from_head <= both_ends) {
+        node1 = list->head->next;
+        for (size_t i = 0; i < min; ++i) {
+            node1 = node1->next;
+        }
+        node2 = node1;
+        for (size_t i = min; i < max; ++i) {
+            node2 = node2->next;
+        }
+    }
+    else if (from_tail <= both_ends) {
+        node2 = list->tail->prev;
+        for (size_t i = list->count - 1; i > max; --i) {
+            node2 = node2->prev;
+        }
+        node1 = node2;
+        for (size_t i = max; i > min; --i) {
+            node1 = node1->prev;
+        }
+    }
+    else {
+        node1 = list->head->next;
+        for (size_t i = 0; i < min; ++i) {
+            node1 = node1->next;
+        }
+        node2 = list->tail->prev;
+        for (size_t i = list->count - 1; i > max; --i) {
+            node2 = node2->prev;
+        }
+    }
+
+    return dll_swap_nodes(list, node1, node2);
 }
 
 void
 dll_print(const dll_t* list, dll_print_fn_t fn, void* arg)
 {
+    DLL_TRACE("dll_print", list);
+
     /* Printing function must be provided (otherwise, what's the point of this function? :)) */
     abort_unless(fn);
 
-    dll_node_t* current = list->head->next;
+    dll_node_t*      current = list->head->next;
+    dll_prefetcher_t pf;
+    dll_prefetcher_init(&pf, current, list->tail);
     while (current != list->tail) {
+        dll_prefetcher_step(&pf);
         fn(current->data, arg);
         current = current->next;
     }
@@ -363,35 +742,150 @@ dll_print(const dll_t* list, dll_print_fn_t fn, void* arg)
 void
 dll_foreach(const dll_t* list, dll_foreach_fn_t fn, void* arg)
 {
+    DLL_TRACE("dll_foreach", list);
+
     /* Function must be provided (otherwise, what's the point of this function? :)) */
     abort_unless(fn);
 
-    dll_node_t* current = list->head->next;
+    dll_node_t*      current = list->head->next;
+    dll_prefetcher_t pf;
+    dll_prefetcher_init(&pf, current, list->tail);
     while (current != list->tail) {
+        dll_prefetcher_step(&pf);
         fn(current->data, arg);
         current = current->next;
 	}
 }
 
+/* Copy one element; the common sizes get a fixed-size (inlined) copy. */
+static inline void
+dll_copy_elem(char* out, const void* elem, const size_t size_of_elem)
+{
+    switch (size_of_elem) {
+        case 4:
+            memcpy(out, elem, 4);
+            break;
+        case 8:
+            memcpy(out, elem, 8);
+            break;
+        default:
+            memcpy(out, elem, size_of_elem);
+            break;
+    }
+}
+
+/* Bytes of an array of @p count elements of @p size_of_elem bytes; aborts if that does not fit in a size_t. */
+static size_t
+dll_array_bytes(const size_t count, const size_t size_of_elem)
+{
+    abort_unless(!size_of_elem || count <= SIZE_MAX / size_of_elem);
+    return count * size_of_elem;
+}
+
+/* Copy the elements of up to @p max nodes, starting at @p node, into @p out. Returns how many were copied. */
+static size_t
+dll_copy_out(const dll_t* list, const dll_node_t* node, const size_t max, char* out, const size_t size_of_elem)
+{
+    // Elements of typed lists are copied straight from their nodes, without chasing data
+    abort_unless(!list->elem_size || size_of_elem == list->elem_size);
+
+    size_t           count = 0;
+    dll_prefetcher_t pf;
+
+    dll_prefetcher_init(&pf, node, list->tail);
+    if (list->elem_size) {
+        for (; count < max && node != list->tail; ++count) {
+            dll_prefetcher_step(&pf);
+            dll_copy_elem(out + count * size_of_elem, node->payload, size_of_elem);
+            node = node->next;
+        }
+    }
+    else {
+        for (; count < max && node != list->tail; ++count) {
+            dll_prefetcher_step(&pf);
+            dll_copy_elem(out + count * size_of_elem, node->data, size_of_elem);
+            node = node->next;
+        }
+    }
+    return count;
+}
+
 void*
 dll_to_array(const dll_t* list, const size_t size_of_elem, size_t* rv_size)
 {
+    DLL_TRACE("dll_to_array", list);
+
+    *rv_size = 0;
     if (list->count == 0) {
         return NULL;
     }
 
-    void*  outarray  = malloc(size_of_elem * list->count);
-    size_t count     = 0;
-    dll_node_t* node = list->head->next;
+    void* outarray = malloc(dll_array_bytes(list->count, size_of_elem));
+    *rv_size       = dll_copy_out(list, list->head->next, list->count, outarray, size_of_elem);
 
-    while (node != list->tail) {
-        memcpy(outarray + count++ * size_of_elem, node->data, size_of_elem);
-        node = node->next;
+    return outarray;
+}
+
+size_t
+dll_to_array_into(const dll_t* list, void* buffer, const size_t capacity, const size_t size_of_elem)
+{
+    DLL_TRACE_ARGS("dll_to_array_into", list, "capacity", capacity, NULL, 0);
+
+    return dll_copy_out(list, list->head->next, capacity, buffer, size_of_elem);
+}
+
+size_t
+dll_to_array_range(const dll_t* list, const size_t first, const size_t count, void* buffer,
+                   const size_t size_of_elem)
+{
+    DLL_TRACE_ARGS("dll_to_array_range", list, "first", first, "count", count);
+
+    const dll_node_t* node = dll_peek_node_at(list, first);
+
+    if (!node) {
+        return 0;
     }
 
-    *rv_size = count;
+    return dll_copy_out(list, node, count, buffer, size_of_elem);
+}
 
-    return outarray;
+size_t
+dll_to_array_reuse(const dll_t* list, const size_t size_of_elem, void** buffer, size_t* capacity)
+{
+    DLL_TRACE("dll_to_array_reuse", list);
+
+    // Only grow, geometrically, so that a steady list size means no allocation at all
+    if (*capacity < list->count) {
+        size_t grown = *capacity ? *capacity : 16;
+        while (grown < list->count) {
+            // Doubling past the count could wrap around: take the exact count instead
+            grown = grown <= SIZE_MAX / 2 ? grown * 2 : list->count;
+        }
+        void* resized = realloc(*buffer, dll_array_bytes(grown, size_of_elem));
+        abort_unless(resized);
+        *buffer   = resized;
+        *capacity = grown;
+    }
+
+    return dll_copy_out(list, list->head->next, list->count, *buffer, size_of_elem);
+}
+
+size_t
+dll_gather(const dll_t* list, void** out, const size_t capacity)
+{
+    DLL_TRACE_ARGS("dll_gather", list, "capacity", capacity, NULL, 0);
+
+    size_t            count = 0;
+    const dll_node_t* node  = list->head->next;
+    dll_prefetcher_t  pf;
+
+    dll_prefetcher_init(&pf, node, list->tail);
+    for (; count < capacity && node != list->tail; ++count) {
+        dll_prefetcher_step(&pf);
+        out[count] = node->data;
+        node       = node->next;
+    }
+    return count;
 }
 
 dll_t*
@@ -400,10 +894,304 @@ dll_from_array(void* array, const size_t count, const size_t size_of_elem)
     dll_t* outlist = dll_create();
 
     for (size_t i = 0; i < count; ++i) {
-        void* data = malloc(count * size_of_elem);
+        void* data = malloc(size_of_elem);
         memcpy(data, array + i*size_of_elem, size_of_elem);
         dll_append(outlist, data);
     }
 
     return outlist;
 }
+
+dll_t*
+dll_from_array_block(const void* array, const size_t count, const size_t size_of_elem)
+{
+    // Sizes that do not fit abort before anything is allocated
+    const size_t node_bytes    = dll_array_bytes(count, sizeof(dll_node_t));
+    const size_t payload_bytes = dll_array_bytes(count, size_of_elem);
+    dll_t*       outlist       = dll_create();
+
+    if (count == 0) {
+        return outlist;
+    }
+
+    // One copy of the whole array, and one allocation for all the nodes
+    dll_node_t* nodes   = malloc(node_bytes);
+    char*       payload = nodes ? malloc(payload_bytes) : NULL;
+    if (!payload) {
+        free(nodes);
+    }
+    abort_unless(nodes && payload);
+    memcpy(payload, array, payload_bytes);
+
+    // Link them in a single pass, in array order
+    dll_node_t* prev = outlist->head;
+    for (size_t i = 0; i < count; ++i) {
+        nodes[i].prev = prev;
+        nodes[i].data = payload + i * size_of_elem;
+        prev->next    = &nodes[i];
+        prev          = &nodes[i];
+    }
+    prev->next          = outlist->tail;
+    outlist->tail->prev = prev;
+
+    outlist->node_block    = nodes;
+    outlist->payload_block = payload;
+    dll_counter_set(outlist->count, count);
+    dll_counter_set(outlist->block_size, count);
+    dll_counter_set(outlist->block_live, count);
+    dll_counter_set(outlist->block_elem, size_of_elem);
+
+    return outlist;
+}
+
+void
+dll_merge(dll_t* list, dll_t* other, dll_cmp_fn_t cmp, void* arg)
+{
+    DLL_TRACE_ARGS("dll_merge", list, "other_size", other->count, NULL, 0);
+
+    abort_unless(cmp);
+    // Nothing changes lists: fine whatever their allocation
+    if (list == other || other->count == 0) {
+        return;
+    }
+
+    // Nodes change lists: both must allocate them the same way
+    abort_unless(list->elem_size == other->elem_size);
+    abort_unless(list->allocator.alloc == other->allocator.alloc && list->allocator.ctx == other->allocator.ctx);
+    // A list owns a single contiguous block (see dll_from_array_block())
+    abort_unless(!list->node_block || !other->node_block);
+
+    dll_node_t* a = list->head->next;
+    dll_node_t* b = other->head->next;
+    while (b != other->tail) {
+        if (a == list->tail) {
+            // Whatever is left of other goes at the end, in one go
+            b->prev                 = list->tail->prev;
+            list->tail->prev->next  = b;
+            other->tail->prev->next = list->tail;
+            list->tail->prev        = other->tail->prev;
+            break;
+        }
+        // Equal elements keep list's ones first
+        if (cmp(b->data, a->data, arg) < 0) {
+            dll_node_t* next = b->next;
+            b->prev          = a->prev;
+            b->next          = a;
+            a->prev->next    = b;
+            a->prev          = b;
+            b                = next;
+        }
+        else {
+            a = a->next;
+        }
+    }
+
+    dll_counter_add(list->count, other->count);
+    if (other->node_block) {
+        list->node_block    = other->node_block;
+        list->payload_block = other->payload_block;
+        dll_counter_set(list->block_size, other->block_size);
+        dll_counter_set(list->block_live, other->block_live);
+        dll_counter_set(list->block_elem, other->block_elem);
+    }
+
+    other->head->next    = other->tail;
+    other->tail->prev    = other->head;
+    other->node_block    = NULL;
+    other->payload_block = NULL;
+    dll_counter_set(other->count, 0);
+    dll_counter_set(other->block_size, 0);
+    dll_counter_set(other->block_live, 0);
+    dll_counter_set(other->block_elem, 0);
+}
+
+/* What a set operation keeps of each input, depending on how their current elements compare. */
+typedef struct {
+    bool only_a; // Elements only in a
+    bool only_b; // Elements only in b
+    bool both;   // Elements in both (taken from a)
+} dll_set_op_t;
+
+static dll_t*
+dll_set_op(const dll_t* a, const dll_t* b, dll_cmp_fn_t cmp, void* arg, const dll_set_op_t op)
+{
+    abort_unless(cmp);
+    abort_unless(a->elem_size == b->elem_size);
+
+    dll_t*            out = dll_create_with_allocator(a->elem_size, &a->allocator);
+    const dll_node_t* x   = a->head->next;
+    const dll_node_t* y   = b->head->next;
+
+    while (x != a->tail && y != b->tail) {
+        const int order = cmp(x->data, y->data, arg);
+        if (order < 0) {
+            if (op.only_a)
+                dll_append_from(out, x);
+            x = x->next;
+        }
+        else if (order > 0) {
+            if (op.only_b)
+                dll_append_from(out, y);
+            y = y->next;
+        }
+        else {
+            if (op.both)
+                dll_append_from(out, x);
+            x = x->next;
+            y = y->next;
+        }
+    }
+    for (; op.only_a && x != a->tail; x = x->next) {
+        dll_append_from(out, x);
+    }
+    for (; op.only_b && y != b->tail; y = y->next) {
+        dll_append_from(out, y);
+    }
+    return out;
+}
+
+dll_t*
+dll_set_union(const dll_t* a, const dll_t* b, dll_cmp_fn_t cmp, void* arg)
+{
+    DLL_TRACE_ARGS("dll_set_union", a, "b_size", b->count, NULL, 0);
+
+    return dll_set_op(a, b, cmp, arg, (dll_set_op_t){ .only_a = true, .only_b = true, .both = true });
+}
+
+dll_t*
+dll_set_intersection(const dll_t* a, const dll_t* b, dll_cmp_fn_t cmp, void* arg)
+{
+    DLL_TRACE_ARGS("dll_set_intersection", a, "b_size", b->count, NULL, 0);
+
+    return dll_set_op(a, b, cmp, arg, (dll_set_op_t){ .only_a = false, .only_b = false, .both = true });
+}
+
+dll_t*
+dll_set_difference(const dll_t* a, const dll_t* b, dll_cmp_fn_t cmp, void* arg)
+{
+    DLL_TRACE_ARGS("dll_set_difference", a, "b_size", b->count, NULL, 0);
+
+    return dll_set_op(a, b, cmp, arg, (dll_set_op_t){ .only_a = true, .only_b = false, .both = false });
+}
+
+bool
+dll_includes(const dll_t* a, const dll_t* b, dll_cmp_fn_t cmp, void* arg)
+{
+    DLL_TRACE_ARGS("dll_includes", a, "b_size", b->count, NULL, 0);
+
+    abort_unless(cmp);
+
+    const dll_node_t* x = a->head->next;
+    const dll_node_t* y = b->head->next;
+
+    while (y != b->tail) {
+        if (x == a->tail) {
+            return false;
+        }
+        const int order = cmp(x->data, y->data, arg);
+        if (order > 0) {
+            // y is smaller than anything left in a
+            return false;
+        }
+        if (order == 0) {
+            y = y->next;
+        }
+        x = x->next;
+    }
+    return true;
+}
+
+/*
+ * Bytes malloc() really takes to serve @p size bytes, 0 if unknown. glibc adds a size word and rounds chunks up
+ * to 2 words, 4 at least.
+ */
+static size_t
+dll_malloc_footprint(const size_t size)
+{
+#ifdef __GLIBC__
+    const size_t word  = sizeof(size_t);
+    const size_t chunk = (size + word + 2 * word - 1) / (2 * word) * (2 * word);
+    return chunk > 4 * word ? chunk : 4 * word;
+#else
+    (void)size;
+    return 0;
+#endif
+}
+
+dll_memory_usage_t
+dll_memory_usage(const dll_t* list)
+{
+    // Each counter is read once. Another thread may be modifying the list between two reads: clamp what
+    // depends on several of them.
+    const size_t count      = dll_counter_get(list->count);
+    const size_t block_size = dll_counter_get(list->block_size);
+    const size_t block_elem = dll_counter_get(list->block_elem);
+    size_t       block_live = dll_counter_get(list->block_live);
+    block_live              = block_live < count ? block_live : count;
+    block_live              = block_live < block_size ? block_live : block_size;
+
+    const size_t       node_size     = sizeof(dll_node_t) + list->elem_size;
+    const size_t       elem_size     = list->elem_size ? list->elem_size : sizeof(void*);
+    const size_t       heap_nodes    = count - block_live;
+    const size_t       sentinel_heap = dll_malloc_footprint(sizeof(dll_node_t));
+    dll_memory_usage_t usage         = {
+        .elements       = count,
+        .payload_bytes  = count * elem_size + block_live * block_elem,
+        .link_bytes     = count * (node_size - elem_size),
+        .sentinel_bytes = 2 * sizeof(dll_node_t) + sizeof(dll_t),
+        .slack_known    = sentinel_heap != 0,
+    };
+
+    // Sentinels and the list always come from malloc
+    if (usage.slack_known) {
+        usage.slack_bytes = 2 * (sentinel_heap - sizeof(dll_node_t)) + dll_malloc_footprint(sizeof(dll_t)) -
+                            sizeof(dll_t);
+    }
+
+    // Blocks stay whole until the list is emptied
+    usage.slack_bytes += (block_size - block_live) * (sizeof(dll_node_t) + block_elem);
+
+    if (heap_nodes && list->allocator.usable_size) {
+        usage.slack_bytes += heap_nodes * (list->allocator.usable_size(list->allocator.ctx, node_size) - node_size);
+    }
+    else if (heap_nodes && list->allocator.alloc == dll_malloc && usage.slack_known) {
+        usage.slack_bytes += heap_nodes * (dll_malloc_footprint(node_size) - node_size);
+    }
+    else if (heap_nodes) {
+        usage.slack_known = false;
+    }
+
+    usage.total_bytes = usage.payload_bytes + usage.link_bytes + usage.sentinel_bytes + usage.slack_bytes;
+    return usage;
+}
+
+dll_memory_usage_t
+dll_memory_usage_total(size_t* lists)
+{
+    dll_memory_usage_t total = { .slack_known = true };
+    size_t             count = 0;
+    dll_hook_t*        hook;
+
+    pthread_once(&dll_registry_once, dll_registry_init);
+    for (size_t i = 0; i < DLL_REGISTRY_SHARDS; ++i) {
+        dll_registry_shard_t* shard = &dll_registry[i];
+        pthread_mutex_lock(&shard->lock);
+        dll_ilist_foreach(&shard->lists, hook) {
+            const dll_memory_usage_t usage = dll_memory_usage(dll_container_of(hook, dll_t, registry_hook));
+            total.elements += usage.elements;
+            total.payload_bytes += usage.payload_bytes;
+            total.link_bytes += usage.link_bytes;
+            total.sentinel_bytes += usage.sentinel_bytes;
+            total.slack_bytes += usage.slack_bytes;
+            total.slack_known = total.slack_known && usage.slack_known;
+            total.total_bytes += usage.total_bytes;
+        }
+        count += dll_ilist_count(&shard->lists);
+        pthread_mutex_unlock(&shard->lock);
+    }
+    if (lists) {
+        *lists = count;
+    }
+
+    return total;
+}
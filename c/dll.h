@@ -11,7 +11,28 @@ typedef struct dll_node_type dll_node_t;
 typedef void (*dll_print_fn_t)(const void* data, void* arg);
 typedef void (*dll_foreach_fn_t)(const void* data, void* arg);
 typedef bool (*dll_find_fn_t)(const void* data, void* arg);
+typedef int  (*dll_cmp_fn_t)(const void* a, const void* b, void* arg);
 typedef void (*dll_free_fn_t)(void* data);
+typedef void (*dll_free_batch_fn_t)(void** data, size_t count);
+
+/*
+ * Where list nodes come from. alloc must return memory aligned for any pointer (or NULL on failure, which
+ * aborts). When free is NULL, nodes are never released one by one: the memory is reclaimed by the allocator's
+ * owner, all at once (see dll_arena_t in dll_alloc.h), and emptying a list does not visit its nodes unless its
+ * elements need freeing.
+ * free_chain is optional: it releases, in one go, allocations chained through their first pointer-sized word
+ * from first to last (the link stored in last is meaningless). Emptying a list then takes O(1) when its
+ * elements need no freeing.
+ * usable_size is optional too: it tells how many bytes an allocation of size bytes really takes, so that
+ * dll_memory_usage() can report the allocator's slack.
+ */
+typedef struct {
+    void*  (*alloc)(void* ctx, size_t size);
+    void   (*free)(void* ctx, void* ptr);
+    void   (*free_chain)(void* ctx, void* first, void* last);
+    size_t (*usable_size)(void* ctx, size_t size);
+    void*    ctx;
+} dll_allocator_t;
 
 /**
  * @brief Create an empty list.
@@ -21,6 +42,43 @@ typedef void (*dll_free_fn_t)(void* data);
 dll_t*
 dll_create(void);
 
+/**
+ * @brief Create an empty typed list: elements of @p elem_size bytes are copied into the list's nodes, so each
+ *        element costs a single allocation and is reached without following a pointer.
+ *        Add elements with dll_append_copy() / dll_prepend_copy() and extract them with dll_extract_at_into();
+ *        the pointer-based modifiers abort on typed lists. Elements are aligned like pointers. Free functions
+ *        given to dll_remove(), dll_empty() or dll_destroy() receive the inline element: they may release
+ *        what it refers to, but must not free it.
+ *
+ * @param elem_size Size of the elements, in bytes (must be positive).
+ *
+ * @return List.
+ */
+dll_t*
+dll_create_typed(size_t elem_size);
+
+/**
+ * @brief Get the size of the inline elements of a typed list.
+ *
+ * @param list List.
+ *
+ * @return Element size in bytes, 0 for lists of pointers.
+ */
+size_t
+dll_elem_size(const dll_t* list);
+
+/**
+ * @brief Create an empty list whose nodes come from a custom allocator.
+ *
+ * @param elem_size Size of the inline elements (see dll_create_typed()), or 0 for a list of pointers.
+ * @param allocator Node allocator, copied into the list (NULL means malloc/free). Its memory must outlive
+ *                  the list.
+ *
+ * @return List.
+ */
+dll_t*
+dll_create_with_allocator(size_t elem_size, const dll_allocator_t* allocator);
+
 /**
  * @brief Destroys a list.
  *
@@ -30,6 +88,15 @@ dll_create(void);
 void
 dll_destroy(dll_t* list, dll_free_fn_t fn);
 
+/**
+ * @brief Destroys a list, handing the elements to a free function in batches.
+ *
+ * @param list List.
+ * @param fn   Function to free the inner nodes' data, given up to 256 elements per call (can be NULL).
+ */
+void
+dll_destroy_batch(dll_t* list, dll_free_batch_fn_t fn);
+
 /**
  * @brief Empty the current list.
  *
@@ -39,6 +106,15 @@ dll_destroy(dll_t* list, dll_free_fn_t fn);
 void
 dll_empty(dll_t* list, dll_free_fn_t fn);
 
+/**
+ * @brief Empty the current list, handing the elements to a free function in batches.
+ *
+ * @param list List.
+ * @param fn   Function to free the inner nodes' data, given up to 256 elements per call (can be NULL).
+ */
+void
+dll_empty_batch(dll_t* list, dll_free_batch_fn_t fn);
+
 /**
  * @brief Test whether the list is empty.
  *
@@ -80,9 +156,31 @@ void
 dll_insert_end(dll_t* list, void* p); 
 #define dll_append(list, data) dll_insert_end(list, data)
 
+/**
+ * @brief Prepend a copy of an element to a typed list.
+ *
+ * @param list List (typed).
+ * @param elem Element to copy, dll_elem_size() bytes long.
+ *
+ * @return Pointer to the copy stored in the list, valid until it is removed.
+ */
+void*
+dll_prepend_copy(dll_t* list, const void* elem);
+
+/**
+ * @brief Append a copy of an element to a typed list.
+ *
+ * @param list List (typed).
+ * @param elem Element to copy, dll_elem_size() bytes long.
+ *
+ * @return Pointer to the copy stored in the list, valid until it is removed.
+ */
+void*
+dll_append_copy(dll_t* list, const void* elem);
+
 /**
  * @brief Get the element at the provided index.
- *        Runs in O(n) (worst case), so don't over-use.
+ *        Walks from the closer end of the list: O(min(index, count - index)), so don't over-use.
  *
  * @param list  List.
  * @param index Position of the element in the list.
@@ -103,11 +201,61 @@ dll_peek_at(const dll_t* list, size_t index);
 void*
 dll_extract_at(dll_t* list, size_t index);
 #define dll_delete_at(list, index) dll_extract_at(list, index)
-#define dll_extract_first(list) dll_extract_at(list, 0)
+
+/**
+ * @brief Get the first element of the list, in O(1).
+ *
+ * @param list List.
+ *
+ * @return First element, or NULL if the list is empty.
+ */
+void*
+dll_peek_first(const dll_t* list);
+
+/**
+ * @brief Get the last element of the list, in O(1).
+ *
+ * @param list List.
+ *
+ * @return Last element, or NULL if the list is empty.
+ */
+void*
+dll_peek_last(const dll_t* list);
+
+/**
+ * @brief Remove (extract) the first element of the list, in O(1).
+ *
+ * @param list List.
+ *
+ * @return First element before removal, or NULL if the list was empty.
+ */
+void*
+dll_extract_first(dll_t* list);
 #define dll_pop_first(list) dll_extract_first(list)
-#define dll_extract_last(list) dll_extract_at(list, dll_count(list) ? dll_count(list)-1 : 0)
+
+/**
+ * @brief Remove (extract) the last element of the list, in O(1).
+ *
+ * @param list List.
+ *
+ * @return Last element before removal, or NULL if the list was empty.
+ */
+void*
+dll_extract_last(dll_t* list);
 #define dll_pop_last(list) dll_extract_last(list)
 
+/**
+ * @brief Remove the element at the provided index from a typed list, copying it out first.
+ *
+ * @param list  List (typed).
+ * @param index Position of the element in the list (to be removed).
+ * @param out   Where to copy the element, dll_elem_size() bytes long.
+ *
+ * @return True if there was an element at @p index.
+ */
+bool
+dll_extract_at_into(dll_t* list, size_t index, void* out);
+
 /**
  * @brief Create a clone of the given list.
  *
@@ -187,13 +335,68 @@ dll_foreach(const dll_t* list, dll_foreach_fn_t fn, void* arg);
  *
  * @param list         List.
  * @param size_of_elem Size of the elements in the list, in bytes.
- * @param rv_size      Size of the output array (i.e., number of elements in it).
+ * @param rv_size      Size of the output array (i.e., number of elements in it), 0 for an empty list.
  *
- * @return Pointer to an array on the heap (caller must free it).
+ * @return Pointer to an array on the heap (caller must free it), or NULL for an empty list.
  */
 void*
 dll_to_array(const dll_t* list, size_t size_of_elem, size_t* rv_size);
 
+/**
+ * @brief Copy the elements of the list into a caller-provided array, without allocating.
+ *
+ * @param list         List.
+ * @param buffer       Output array.
+ * @param capacity     Number of elements that fit in @p buffer.
+ * @param size_of_elem Size of the elements in the list, in bytes.
+ *
+ * @return Number of elements copied: the smallest of the list's count and @p capacity.
+ */
+size_t
+dll_to_array_into(const dll_t* list, void* buffer, size_t capacity, size_t size_of_elem);
+
+/**
+ * @brief Copy a range of elements of the list into a caller-provided array, without allocating.
+ *        The walk to @p first starts from the closer end of the list.
+ *
+ * @param list         List.
+ * @param first        Position of the first element to copy.
+ * @param count        Maximum number of elements to copy (@p buffer must fit them).
+ * @param buffer       Output array.
+ * @param size_of_elem Size of the elements in the list, in bytes.
+ *
+ * @return Number of elements copied (fewer than @p count if the list ends first, 0 if @p first is out of range).
+ */
+size_t
+dll_to_array_range(const dll_t* list, size_t first, size_t count, void* buffer, size_t size_of_elem);
+
+/**
+ * @brief Copy the elements of the list into a reusable heap array, growing it only when it is too small.
+ *        Exporting a list of stable size every tick then allocates nothing after the first call.
+ *
+ * @param list         List.
+ * @param size_of_elem Size of the elements in the list, in bytes.
+ * @param buffer       In/out: array from a previous call (or NULL); the caller must free it eventually.
+ * @param capacity     In/out: number of elements that fit in @p buffer (0 along with a NULL @p buffer).
+ *
+ * @return Number of elements copied, i.e. the list's count.
+ */
+size_t
+dll_to_array_reuse(const dll_t* list, size_t size_of_elem, void** buffer, size_t* capacity);
+
+/**
+ * @brief Gather the elements' pointers (their data, not copies) into a caller-provided array.
+ *        For typed lists these point inside the nodes, and stay valid until the elements are removed.
+ *
+ * @param list     List.
+ * @param out      Output array of pointers.
+ * @param capacity Number of pointers that fit in @p out.
+ *
+ * @return Number of pointers gathered: the smallest of the list's count and @p capacity.
+ */
+size_t
+dll_gather(const dll_t* list, void** out, size_t capacity);
+
 /**
  * @brief Given an input array, create a list containing its elements.
  *        Note that elements will be allocated dynamically, so these need to be free'd when destroying the output list.
@@ -206,4 +409,132 @@ dll_to_array(const dll_t* list, size_t size_of_elem, size_t* rv_size);
  */
 dll_t*
 dll_from_array(void* array, size_t count, size_t size_of_elem);
+
+/**
+ * @brief Given an input array, create a list containing its elements, using two allocations in total:
+ *        one block holding a copy of the array, and one block holding all the nodes.
+ *        The list owns both blocks: its elements must not be free'd one by one (the free function passed to
+ *        dll_remove(), dll_empty() or dll_destroy() is not called on them), and pointers to them, extracted
+ *        ones included, stay valid until the list is emptied or destroyed. Emptying or destroying a list
+ *        holding only such elements takes O(1).
+ *
+ * @param array        Array containing the elements.
+ * @param count        Number of elements in @p array.
+ * @param size_of_elem Size of the elements in the array, in bytes.
+ *
+ * @return List containing all elements in the input array.
+ */
+dll_t*
+dll_from_array_block(const void* array, size_t count, size_t size_of_elem);
+
+/*
+ * Sorted lists. These work on lists sorted in ascending order by the comparator, which returns a negative
+ * number, zero or a positive number when its first element is smaller than, equal to or greater than its
+ * second one (like qsort's, plus an argument). They all run in linear time. Repeated elements are handled like
+ * multisets, as std::set_union & co. do. Results are new lists of the same kind as @p a, with the same
+ * allocator: typed elements are copied, pointer elements are shared.
+ */
+
+/**
+ * @brief Move all the elements of @p other into @p list, keeping it sorted. Nodes are relinked, not copied:
+ *        nothing is allocated. Equal elements keep their order, those of @p list first.
+ *        Both lists must have the same element size and allocator, and at most one of them may hold elements
+ *        from dll_from_array_block().
+ *
+ * @param list  Sorted list, receiving the elements.
+ * @param other Sorted list, empty afterwards.
+ * @param cmp   Comparator (must be provided).
+ * @param arg   Argument sent to @p cmp.
+ */
+void
+dll_merge(dll_t* list, dll_t* other, dll_cmp_fn_t cmp, void* arg);
+
+/**
+ * @brief Elements in @p a, in @p b, or in both.
+ *
+ * @param a   Sorted list.
+ * @param b   Sorted list.
+ * @param cmp Comparator (must be provided).
+ * @param arg Argument sent to @p cmp.
+ *
+ * @return New sorted list.
+ */
+dll_t*
+dll_set_union(const dll_t* a, const dll_t* b, dll_cmp_fn_t cmp, void* arg);
+
+/**
+ * @brief Elements in both @p a and @p b (taken from @p a).
+ *
+ * @param a   Sorted list.
+ * @param b   Sorted list.
+ * @param cmp Comparator (must be provided).
+ * @param arg Argument sent to @p cmp.
+ *
+ * @return New sorted list.
+ */
+dll_t*
+dll_set_intersection(const dll_t* a, const dll_t* b, dll_cmp_fn_t cmp, void* arg);
+
+/**
+ * @brief Elements in @p a but not in @p b.
+ *
+ * @param a   Sorted list.
+ * @param b   Sorted list.
+ * @param cmp Comparator (must be provided).
+ * @param arg Argument sent to @p cmp.
+ *
+ * @return New sorted list.
+ */
+dll_t*
+dll_set_difference(const dll_t* a, const dll_t* b, dll_cmp_fn_t cmp, void* arg);
+
+/**
+ * @brief Test whether every element of @p b is also in @p a.
+ *
+ * @param a   Sorted list.
+ * @param b   Sorted list.
+ * @param cmp Comparator (must be provided).
+ * @param arg Argument sent to @p cmp.
+ *
+ * @return True if @p a includes @p b.
+ */
+bool
+dll_includes(const dll_t* a, const dll_t* b, dll_cmp_fn_t cmp, void* arg);
+
+/*
+ * Memory accounting. Only memory owned by lists is counted: the elements pointer lists point to are the
+ * caller's (but for the copies dll_from_array_block() makes).
+ */
+
+typedef struct {
+    size_t elements;
+    size_t payload_bytes;  // Inline elements of typed lists, data pointers of pointer lists, block copies
+    size_t link_bytes;     // Rest of the element nodes: links (and data pointers of typed lists)
+    size_t sentinel_bytes; // Head and tail sentinels, and the list itself
+    size_t slack_bytes;    // Allocator headers and rounding, and block nodes no longer in the list
+    bool   slack_known;    // False when the allocator cannot tell its overhead (slack_bytes is then partial)
+    size_t total_bytes;    // Sum of all the above
+} dll_memory_usage_t;
+
+/**
+ * @brief Get the memory footprint of a list, in O(1).
+ *
+ * @param list List.
+ *
+ * @return Memory usage.
+ */
+dll_memory_usage_t
+dll_memory_usage(const dll_t* list);
+
+/**
+ * @brief Add up the memory footprint of every live list of the process. Safe while other threads modify their
+ *        lists: only their counters are read, atomically, and a list being modified meanwhile adds figures from
+ *        just before or after each change.
+ *
+ * @param lists If not NULL, set to the number of live lists.
+ *
+ * @return Memory usage of all lists together.
+ */
+dll_memory_usage_t
+dll_memory_usage_total(size_t* lists);
 #endif /* DOUBLYLINKEDLIST_H_ */
@@ -0,0 +1,227 @@
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "dll_alloc.h"
+#include "dll_internal.h"
+
+#define DLL_POOL_CHUNK_SLOTS   256
+#define DLL_ARENA_DEFAULT_SIZE (64 * 1024)
+
+/* Chunks of both allocators are chained through this header, placed at their start. */
+typedef struct dll_chunk_type {
+    struct dll_chunk_type* next;
+    size_t                 size; // Usable bytes after the header
+    alignas(max_align_t) unsigned char memory[];
+} dll_chunk_t;
+
+/* Free slots of a pool are chained through their first word. */
+typedef struct dll_slot_type {
+    struct dll_slot_type* next;
+} dll_slot_t;
+
+struct dll_node_pool_type {
+    size_t       slot_size;
+    dll_slot_t*  free_slots;
+    dll_chunk_t* chunks;
+};
+
+struct dll_arena_type {
+    size_t       chunk_size;
+    size_t       used; // Bytes handed out from the current (first) chunk
+    dll_chunk_t* chunks;
+};
+
+static size_t
+dll_align_up(const size_t size, const size_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+static dll_chunk_t*
+dll_chunk_create(const size_t size, dll_chunk_t* next)
+{
+    dll_chunk_t* chunk = malloc(sizeof *chunk + size);
+    abort_unless(chunk);
+    chunk->next = next;
+    chunk->size = size;
+    return chunk;
+}
+
+static void
+dll_chunks_destroy(dll_chunk_t* chunk)
+{
+    while (chunk) {
+        dll_chunk_t* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+}
+
+static void*
+dll_node_pool_alloc(void* ctx, const size_t size)
+{
+    dll_node_pool_t* pool = ctx;
+    abort_unless(size <= pool->slot_size);
+
+    if (!pool->free_slots) {
+        // Carve a new chunk into slots, chained in address order
+        pool->chunks = dll_chunk_create(DLL_POOL_CHUNK_SLOTS * pool->slot_size, pool->chunks);
+        for (size_t i = DLL_POOL_CHUNK_SLOTS; i-- > 0;) {
+            dll_slot_t* slot = (dll_slot_t*)(pool->chunks->memory + i * pool->slot_size);
+            slot->next       = pool->free_slots;
+            pool->free_slots = slot;
+        }
+    }
+
+    dll_slot_t* slot = pool->free_slots;
+    pool->free_slots = slot->next;
+    return slot;
+}
+
+static void
+dll_node_pool_free(void* ctx, void* ptr)
+{
+    dll_node_pool_t* pool = ctx;
+    dll_slot_t*      slot = ptr;
+    slot->next            = pool->free_slots;
+    pool->free_slots      = slot;
+}
+
+/* Nodes start with their next link, so a chain of nodes already is a chain of free slots. */
+_Static_assert(offsetof(dll_node_t, next) == offsetof(dll_slot_t, next), "nodes must chain like slots");
+
+static void
+dll_node_pool_free_chain(void* ctx, void* first, void* last)
+{
+    dll_node_pool_t* pool = ctx;
+    ((dll_slot_t*)last)->next = pool->free_slots;
+    pool->free_slots          = first;
+}
+
+static size_t
+dll_node_pool_usable_size(void* ctx, const size_t size)
+{
+    (void)size;
+    return ((const dll_node_pool_t*)ctx)->slot_size;
+}
+
+dll_node_pool_t*
+dll_node_pool_create(const size_t elem_size)
+{
+    dll_node_pool_t* pool = malloc(sizeof *pool);
+
+    pool->slot_size  = dll_align_up(sizeof(dll_node_t) + elem_size, alignof(dll_node_t));
+    pool->free_slots = NULL;
+    pool->chunks     = NULL;
+
+    return pool;
+}
+
+void
+dll_node_pool_destroy(dll_node_pool_t* pool)
+{
+    dll_chunks_destroy(pool->chunks);
+    free(pool);
+}
+
+dll_allocator_t
+dll_node_pool_allocator(dll_node_pool_t* pool)
+{
+    return (dll_allocator_t){
+        .alloc       = dll_node_pool_alloc,
+        .free        = dll_node_pool_free,
+        .free_chain  = dll_node_pool_free_chain,
+        .usable_size = dll_node_pool_usable_size,
+        .ctx         = pool,
+    };
+}
+
+static void*
+dll_arena_alloc(void* ctx, const size_t size)
+{
+    dll_arena_t* arena   = ctx;
+    const size_t aligned = dll_align_up(size, alignof(max_align_t));
+
+    if (aligned > arena->chunk_size) {
+        // Too big to share a chunk: give it one of its own, behind the current one
+        dll_chunk_t* chunk = dll_chunk_create(aligned, NULL);
+        if (arena->chunks) {
+            chunk->next         = arena->chunks->next;
+            arena->chunks->next = chunk;
+        }
+        else {
+            arena->chunks = chunk;
+            arena->used   = aligned;
+        }
+        return chunk->memory;
+    }
+
+    if (!arena->chunks || arena->used + aligned > arena->chunks->size) {
+        arena->chunks = dll_chunk_create(arena->chunk_size, arena->chunks);
+        arena->used   = 0;
+    }
+
+    void* ptr = arena->chunks->memory + arena->used;
+    arena->used += aligned;
+    return ptr;
+}
+
+static size_t
+dll_arena_usable_size(void* ctx, const size_t size)
+{
+    (void)ctx;
+    return dll_align_up(size, alignof(max_align_t));
+}
+
+dll_arena_t*
+dll_arena_create(const size_t chunk_size)
+{
+    dll_arena_t* arena = malloc(sizeof *arena);
+
+    arena->chunk_size = chunk_size ? chunk_size : DLL_ARENA_DEFAULT_SIZE;
+    arena->used       = 0;
+    arena->chunks     = NULL;
+
+    return arena;
+}
+
+void
+dll_arena_reset(dll_arena_t* arena)
+{
+    if (!arena->chunks) {
+        return;
+    }
+
+    // Keep the newest chunk if it is a regular one
+    dll_chunk_t* keep = arena->chunks;
+    if (keep->size != arena->chunk_size) {
+        dll_chunks_destroy(keep);
+        arena->chunks = NULL;
+    }
+    else {
+        dll_chunks_destroy(keep->next);
+        keep->next = NULL;
+    }
+    arena->used = 0;
+}
+
+void
+dll_arena_destroy(dll_arena_t* arena)
+{
+    dll_chunks_destroy(arena->chunks);
+    free(arena);
+}
+
+dll_allocator_t
+dll_arena_allocator(dll_arena_t* arena)
+{
+    return (dll_allocator_t){
+        .alloc       = dll_arena_alloc,
+        .free        = NULL,
+        .free_chain  = NULL,
+        .usable_size = dll_arena_usable_size,
+        .ctx         = arena,
+    };
+}
@@ -0,0 +1,88 @@
+#ifndef DOUBLYLINKEDLIST_ALLOC_H_
+#define DOUBLYLINKEDLIST_ALLOC_H_
+
+#include <stddef.h>
+
+#include "dll.h"
+
+/*
+ * Built-in node allocators for dll_create_with_allocator(). Neither is thread-safe: give each thread its
+ * own pool or arena, or only use them from lists that are never shared.
+ *
+ * - The node pool hands out fixed-size slots, carved from big chunks and recycled through a free list, so
+ *   allocating and freeing a node is a couple of pointer moves and nodes stay close together in memory.
+ * - The arena only bumps a pointer and never frees a node: lists using it are emptied and destroyed
+ *   without visiting their nodes, and all the memory goes back at once with dll_arena_reset() or
+ *   dll_arena_destroy().
+ */
+
+typedef struct dll_node_pool_type dll_node_pool_t;
+typedef struct dll_arena_type     dll_arena_t;
+
+/**
+ * @brief Create a node pool.
+ *
+ * @param elem_size Size of the inline elements of the lists it will serve (0 for lists of pointers).
+ *
+ * @return Node pool.
+ */
+dll_node_pool_t*
+dll_node_pool_create(size_t elem_size);
+
+/**
+ * @brief Destroy a node pool, releasing every node at once. No list may be using it anymore.
+ *
+ * @param pool Node pool.
+ */
+void
+dll_node_pool_destroy(dll_node_pool_t* pool);
+
+/**
+ * @brief Get the allocator to give to dll_create_with_allocator() (with the pool's element size).
+ *
+ * @param pool Node pool.
+ *
+ * @return Allocator backed by @p pool.
+ */
+dll_allocator_t
+dll_node_pool_allocator(dll_node_pool_t* pool);
+
+/**
+ * @brief Create an arena.
+ *
+ * @param chunk_size Bytes requested from malloc at a time (0 picks a default). Bigger allocations get a chunk
+ *                   of their own.
+ *
+ * @return Arena.
+ */
+dll_arena_t*
+dll_arena_create(size_t chunk_size);
+
+/**
+ * @brief Release all the memory handed out by the arena, keeping its first chunk for reuse.
+ *        Lists using it must have been emptied or destroyed before.
+ *
+ * @param arena Arena.
+ */
+void
+dll_arena_reset(dll_arena_t* arena);
+
+/**
+ * @brief Destroy an arena and all the memory it handed out. No list may be using it anymore.
+ *
+ * @param arena Arena.
+ */
+void
+dll_arena_destroy(dll_arena_t* arena);
+
+/**
+ * @brief Get the allocator to give to dll_create_with_allocator(). Its free function is NULL.
+ *
+ * @param arena Arena.
+ *
+ * @return Allocator backed by @p arena.
+ */
+dll_allocator_t
+dll_arena_allocator(dll_arena_t* arena);
+
+#endif /* DOUBLYLINKEDLIST_ALLOC_H_ */
@@ -0,0 +1,286 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "dll_channel.h"
+#include "dll_internal.h"
+
+struct dll_channel_type {
+    dll_t*          list;
+    size_t          capacity;
+    bool            closed;
+    pthread_mutex_t lock;
+    pthread_cond_t  not_empty;
+    pthread_cond_t  not_full;
+};
+
+dll_channel_t*
+dll_channel_create(const size_t capacity)
+{
+    dll_channel_t* channel = malloc(sizeof *channel);
+
+    channel->list     = dll_create();
+    channel->capacity = capacity;
+    channel->closed   = false;
+
+    // Timed waits are measured on the monotonic clock, immune to wall-clock jumps
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&channel->lock, NULL);
+    pthread_cond_init(&channel->not_empty, &attr);
+    pthread_cond_init(&channel->not_full, &attr);
+    pthread_condattr_destroy(&attr);
+
+    return channel;
+}
+
+void
+dll_channel_destroy(dll_channel_t* channel, dll_free_fn_t fn)
+{
+    dll_destroy(channel->list, fn);
+    pthread_cond_destroy(&channel->not_full);
+    pthread_cond_destroy(&channel->not_empty);
+    pthread_mutex_destroy(&channel->lock);
+    free(channel);
+}
+
+void
+dll_channel_close(dll_channel_t* channel)
+{
+    pthread_mutex_lock(&channel->lock);
+    channel->closed = true;
+    pthread_cond_broadcast(&channel->not_empty);
+    pthread_cond_broadcast(&channel->not_full);
+    pthread_mutex_unlock(&channel->lock);
+}
+
+bool
+dll_channel_is_closed(dll_channel_t* channel)
+{
+    pthread_mutex_lock(&channel->lock);
+    const bool closed = channel->closed;
+    pthread_mutex_unlock(&channel->lock);
+    return closed;
+}
+
+size_t
+dll_channel_count(dll_channel_t* channel)
+{
+    pthread_mutex_lock(&channel->lock);
+    const size_t count = channel->list->count;
+    pthread_mutex_unlock(&channel->lock);
+    return count;
+}
+
+/* Turn a relative timeout into an absolute deadline (NULL means no deadline). */
+static const struct timespec*
+dll_channel_deadline(struct timespec* deadline, const long timeout_ms)
+{
+    if (timeout_ms < 0) {
+        return NULL;
+    }
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec  += timeout_ms / 1000;
+    deadline->tv_nsec += (timeout_ms % 1000) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+    return deadline;
+}
+
+/* Wait on @p cond with the channel locked. Returns false once the deadline has passed. */
+static bool
+dll_channel_wait(dll_channel_t* channel, pthread_cond_t* cond, const struct timespec* deadline)
+{
+    if (!deadline) {
+        pthread_cond_wait(cond, &channel->lock);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, &channel->lock, deadline) != ETIMEDOUT;
+}
+
+static bool
+dll_channel_is_full(const dll_channel_t* channel)
+{
+    return channel->capacity && channel->list->count >= channel->capacity;
+}
+
+/* Link the chain first..last (n nodes) at the end of the list. Channel must be locked. */
+static void
+dll_channel_splice(dll_channel_t* channel, dll_node_t* first, dll_node_t* last, const size_t n)
+{
+    dll_t* list = channel->list;
+
+    first->prev            = list->tail->prev;
+    last->next             = list->tail;
+    list->tail->prev->next = first;
+    list->tail->prev       = last;
+    dll_counter_add(list->count, n);
+
+    if (n == 1)
+        pthread_cond_signal(&channel->not_empty);
+    else
+        pthread_cond_broadcast(&channel->not_empty);
+}
+
+/* Unlink up to @p max nodes from the front, storing their data in @p out. Channel must be locked. */
+static size_t
+dll_channel_detach(dll_channel_t* channel, void** out, const size_t max, dll_node_t** first)
+{
+    dll_t*       list = channel->list;
+    const size_t n    = list->count < max ? list->count : max;
+    dll_node_t*  node = list->head->next;
+
+    *first = node;
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = node->data;
+        node   = node->next;
+    }
+    // node is now the first one staying in the list; cut the chain before it
+    node->prev->next = NULL;
+    node->prev       = list->head;
+    list->head->next = node;
+    dll_counter_sub(list->count, n);
+
+    if (channel->capacity) {
+        if (n == 1)
+            pthread_cond_signal(&channel->not_full);
+        else
+            pthread_cond_broadcast(&channel->not_full);
+    }
+    return n;
+}
+
+static void
+dll_channel_free_chain(const dll_channel_t* channel, dll_node_t* node)
+{
+    while (node) {
+        dll_node_t* next = node->next;
+        dll_node_free(channel->list, node);
+        node = next;
+    }
+}
+
+static size_t
+dll_channel_push_n(dll_channel_t* channel, void* const* items, const size_t count, const long timeout_ms,
+                   bool* closed)
+{
+    // Build the whole chain before locking
+    dll_node_t* first = NULL;
+    dll_node_t* last  = NULL;
+    for (size_t i = 0; i < count; ++i) {
+        dll_node_t* node = dll_node_alloc(channel->list);
+        node->data = items[i];
+        node->prev = last;
+        node->next = NULL;
+        if (last)
+            last->next = node;
+        else
+            first = node;
+        last = node;
+    }
+
+    struct timespec        ts;
+    const struct timespec* deadline = dll_channel_deadline(&ts, timeout_ms);
+    size_t                 pushed   = 0;
+
+    pthread_mutex_lock(&channel->lock);
+    while (pushed < count) {
+        while (!channel->closed && dll_channel_is_full(channel)) {
+            if (timeout_ms == 0 || !dll_channel_wait(channel, &channel->not_full, deadline))
+                break;
+        }
+        if (channel->closed || dll_channel_is_full(channel)) {
+            *closed = channel->closed;
+            break;
+        }
+
+        const size_t left = count - pushed;
+        const size_t room = channel->capacity ? channel->capacity - channel->list->count : left;
+        const size_t n    = room < left ? room : left;
+
+        // Only a partial run needs walking to find where to cut the chain
+        dll_node_t* run_first = first;
+        dll_node_t* run_last  = last;
+        if (n < left) {
+            run_last = first;
+            for (size_t i = 1; i < n; ++i) {
+                run_last = run_last->next;
+            }
+            first       = run_last->next;
+            first->prev = NULL;
+        }
+        else {
+            first = NULL;
+        }
+        dll_channel_splice(channel, run_first, run_last, n);
+        pushed += n;
+    }
+    pthread_mutex_unlock(&channel->lock);
+
+    dll_channel_free_chain(channel, first);
+    return pushed;
+}
+
+static size_t
+dll_channel_pop_n(dll_channel_t* channel, void** out, const size_t max, const long timeout_ms, bool* closed)
+{
+    struct timespec        ts;
+    const struct timespec* deadline = dll_channel_deadline(&ts, timeout_ms);
+    dll_node_t*            first    = NULL;
+    size_t                 popped   = 0;
+
+    pthread_mutex_lock(&channel->lock);
+    while (!channel->closed && channel->list->count == 0) {
+        if (timeout_ms == 0 || !dll_channel_wait(channel, &channel->not_empty, deadline))
+            break;
+    }
+    if (channel->list->count) {
+        popped = dll_channel_detach(channel, out, max, &first);
+    }
+    *closed = channel->closed;
+    pthread_mutex_unlock(&channel->lock);
+
+    // Nodes are released outside of the critical section
+    dll_channel_free_chain(channel, popped ? first : NULL);
+    return popped;
+}
+
+dll_channel_status_t
+dll_channel_push_timed(dll_channel_t* channel, void* p, const long timeout_ms)
+{
+    bool closed = false;
+    if (dll_channel_push_n(channel, &p, 1, timeout_ms, &closed) == 1) {
+        return DLL_CHANNEL_OK;
+    }
+    return closed ? DLL_CHANNEL_CLOSED : DLL_CHANNEL_TIMEOUT;
+}
+
+dll_channel_status_t
+dll_channel_pop_timed(dll_channel_t* channel, void** out, const long timeout_ms)
+{
+    bool closed = false;
+    if (dll_channel_pop_n(channel, out, 1, timeout_ms, &closed) == 1) {
+        return DLL_CHANNEL_OK;
+    }
+    return closed ? DLL_CHANNEL_CLOSED : DLL_CHANNEL_TIMEOUT;
+}
+
+size_t
+dll_channel_push_batch(dll_channel_t* channel, void* const* items, const size_t count, const long timeout_ms)
+{
+    bool closed = false;
+    return count ? dll_channel_push_n(channel, items, count, timeout_ms, &closed) : 0;
+}
+
+size_t
+dll_channel_pop_batch(dll_channel_t* channel, void** out, const size_t max, const long timeout_ms)
+{
+    bool closed = false;
+    return max ? dll_channel_pop_n(channel, out, max, timeout_ms, &closed) : 0;
+}
@@ -0,0 +1,128 @@
+#ifndef DOUBLYLINKEDLIST_CHANNEL_H_
+#define DOUBLYLINKEDLIST_CHANNEL_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "dll.h"
+
+/*
+ * Blocking, optionally bounded, multi-producer multi-consumer FIFO channel built on dll_t.
+ * All functions are thread-safe. Timeouts are given in milliseconds; DLL_CHANNEL_WAIT_FOREVER
+ * blocks until the operation can complete or the channel is closed, and 0 never blocks.
+ */
+
+typedef struct dll_channel_type dll_channel_t;
+
+#define DLL_CHANNEL_WAIT_FOREVER (-1L)
+
+typedef enum {
+    DLL_CHANNEL_OK = 0,
+    DLL_CHANNEL_TIMEOUT,
+    DLL_CHANNEL_CLOSED,
+} dll_channel_status_t;
+
+/**
+ * @brief Create a channel.
+ *
+ * @param capacity Maximum number of queued elements (0 means unbounded).
+ *
+ * @return Channel.
+ */
+dll_channel_t*
+dll_channel_create(size_t capacity);
+
+/**
+ * @brief Destroy a channel. No thread may be using it anymore.
+ *
+ * @param channel Channel.
+ * @param fn      Function to free the elements still queued (can be NULL).
+ */
+void
+dll_channel_destroy(dll_channel_t* channel, dll_free_fn_t fn);
+
+/**
+ * @brief Close the channel: pushes fail from now on, pops drain what is left and then fail.
+ *        Every blocked thread is woken up. Closing twice is harmless.
+ *
+ * @param channel Channel.
+ */
+void
+dll_channel_close(dll_channel_t* channel);
+
+/**
+ * @brief Test whether the channel was closed.
+ *
+ * @param channel Channel.
+ *
+ * @return True if closed.
+ */
+bool
+dll_channel_is_closed(dll_channel_t* channel);
+
+/**
+ * @brief Get the number of queued elements (a snapshot, it may change right away).
+ *
+ * @param channel Channel.
+ *
+ * @return Element count.
+ */
+size_t
+dll_channel_count(dll_channel_t* channel);
+
+/**
+ * @brief Push an element, waiting for free capacity for at most @p timeout_ms.
+ *
+ * @param channel    Channel.
+ * @param p          Element to push.
+ * @param timeout_ms Timeout in milliseconds.
+ *
+ * @return DLL_CHANNEL_OK if pushed, DLL_CHANNEL_TIMEOUT or DLL_CHANNEL_CLOSED otherwise.
+ */
+dll_channel_status_t
+dll_channel_push_timed(dll_channel_t* channel, void* p, long timeout_ms);
+#define dll_channel_push(channel, p) dll_channel_push_timed(channel, p, DLL_CHANNEL_WAIT_FOREVER)
+#define dll_channel_try_push(channel, p) dll_channel_push_timed(channel, p, 0)
+
+/**
+ * @brief Pop the oldest element, waiting for one for at most @p timeout_ms.
+ *
+ * @param channel    Channel.
+ * @param out        Where to store the popped element.
+ * @param timeout_ms Timeout in milliseconds.
+ *
+ * @return DLL_CHANNEL_OK if popped, DLL_CHANNEL_TIMEOUT, or DLL_CHANNEL_CLOSED once closed and drained.
+ */
+dll_channel_status_t
+dll_channel_pop_timed(dll_channel_t* channel, void** out, long timeout_ms);
+#define dll_channel_pop(channel, out) dll_channel_pop_timed(channel, out, DLL_CHANNEL_WAIT_FOREVER)
+#define dll_channel_try_pop(channel, out) dll_channel_pop_timed(channel, out, 0)
+
+/**
+ * @brief Push several elements in order, locking once per run of free capacity.
+ *        Nodes are allocated before taking the lock, so the critical section is a splice.
+ *
+ * @param channel    Channel.
+ * @param items      Elements to push.
+ * @param count      Number of elements in @p items.
+ * @param timeout_ms Timeout in milliseconds for the whole batch.
+ *
+ * @return Number of elements pushed: less than @p count on timeout or close.
+ */
+size_t
+dll_channel_push_batch(dll_channel_t* channel, void* const* items, size_t count, long timeout_ms);
+
+/**
+ * @brief Pop up to @p max elements under a single lock, waiting for at least one for at most @p timeout_ms.
+ *
+ * @param channel    Channel.
+ * @param out        Array receiving the popped elements, oldest first.
+ * @param max        Capacity of @p out.
+ * @param timeout_ms Timeout in milliseconds.
+ *
+ * @return Number of elements popped: 0 on timeout, or once closed and drained.
+ */
+size_t
+dll_channel_pop_batch(dll_channel_t* channel, void** out, size_t max, long timeout_ms);
+
+#endif /* DOUBLYLINKEDLIST_CHANNEL_H_ */
@@ -0,0 +1,179 @@
+#ifndef DOUBLYLINKEDLIST_INTERNAL_H_
+#define DOUBLYLINKEDLIST_INTERNAL_H_
+
+/*
+ * Private to the library: layout of the list types, shared by the modules built on top of dll_t.
+ * Not installed, not part of the API.
+ */
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "dll.h"
+#include "dll_intrusive.h"
+
+#define abort_unless(expr) \
+    if (!(expr)) {\
+        fprintf(stderr, "Aborting since condition \"%s\" wan't met.\n", #expr);\
+        abort();\
+    }
+
+struct dll_node_type {
+    struct dll_node_type* next;
+    struct dll_node_type* prev;
+    void*                 data;
+    // Element of typed lists, stored inline (data then points here); empty for pointer lists
+    unsigned char payload[];
+};
+
+/*
+ * Counters of a list that dll_memory_usage_total() reads from any thread while the list is modified: relaxed
+ * atomic loads and stores, plain moves on common hardware. Never read-modify-writes, since only one thread at a
+ * time may modify a list. Plain reads of the fields are atomic too, just not relaxed.
+ */
+#define dll_counter_get(counter)        atomic_load_explicit(&(counter), memory_order_relaxed)
+#define dll_counter_set(counter, value) atomic_store_explicit(&(counter), (value), memory_order_relaxed)
+#define dll_counter_add(counter, delta) dll_counter_set(counter, dll_counter_get(counter) + (delta))
+#define dll_counter_sub(counter, delta) dll_counter_set(counter, dll_counter_get(counter) - (delta))
+
+struct dll_type {
+    dll_node_t*   head;
+    dll_node_t*   tail;
+    atomic_size_t count;
+    // Size of the inline elements of typed lists, 0 for lists of pointers
+    size_t      elem_size;
+    // Where the element nodes come from (sentinels always use malloc)
+    dll_allocator_t allocator;
+
+    // Contiguous storage made by dll_from_array_block(), released with the list
+    dll_node_t* node_block;
+    void*       payload_block;
+    atomic_size_t block_size; // Nodes in node_block
+    atomic_size_t block_live; // Nodes of node_block still linked in the list
+    atomic_size_t block_elem; // Bytes per element in payload_block
+
+    // Links the list into a shard of the registry of live lists, for dll_memory_usage_total()
+    dll_hook_t registry_hook;
+    unsigned   registry_shard;
+};
+
+/* Elements handed at once to the batched free functions of dll_empty_batch() and dll_destroy_batch(). */
+#define DLL_FREE_BATCH 256
+
+/* A node with room for the list's inline element, if any. */
+static inline dll_node_t*
+dll_node_alloc(const dll_t* list)
+{
+    dll_node_t* node = list->allocator.alloc(list->allocator.ctx, sizeof(dll_node_t) + list->elem_size);
+    abort_unless(node);
+    return node;
+}
+
+static inline void
+dll_node_free(const dll_t* list, dll_node_t* node)
+{
+    if (list->allocator.free) {
+        list->allocator.free(list->allocator.ctx, node);
+    }
+}
+
+/*
+ * Traversal prefetching. Full-list walks keep a second cursor DLL_PREFETCH_DISTANCE nodes ahead of
+ * the node being visited and prefetch what it reaches, so the cache misses of upcoming nodes (and of
+ * their payloads) overlap with the work done on the current one. Build with -DDLL_PREFETCH_DISTANCE=N
+ * to tune it, 0 disables it.
+ */
+#ifndef DLL_PREFETCH_DISTANCE
+#define DLL_PREFETCH_DISTANCE 4
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define dll_prefetch(addr) __builtin_prefetch(addr)
+#else
+#define dll_prefetch(addr) ((void)(addr))
+#endif
+
+typedef struct {
+    const dll_node_t* ahead;
+    const dll_node_t* end;
+} dll_prefetcher_t;
+
+/* Start a forward walk at @p first; @p end is the sentinel closing it. */
+static inline void
+dll_prefetcher_init(dll_prefetcher_t* pf, const dll_node_t* first, const dll_node_t* end)
+{
+    pf->ahead = first;
+    pf->end   = end;
+    for (int i = 0; i < DLL_PREFETCH_DISTANCE && pf->ahead != end; ++i) {
+        pf->ahead = pf->ahead->next;
+        dll_prefetch(pf->ahead);
+    }
+}
+
+/* Move the look-ahead cursor by one node: call it once per visited node, before freeing that node. */
+static inline void
+dll_prefetcher_step(dll_prefetcher_t* pf)
+{
+    if (DLL_PREFETCH_DISTANCE > 0 && pf->ahead != pf->end) {
+        dll_prefetch(pf->ahead->data);
+        pf->ahead = pf->ahead->next;
+        dll_prefetch(pf->ahead);
+    }
+}
+
+/*
+ * Tracing (see dll_trace.h). DLL_TRACE() at the top of a function records its call when the function
+ * returns, however it does. Only the outermost traced call of a thread is recorded.
+ */
+typedef struct {
+    const char* name;
+    const char* arg_names[2]; // NULL for unused arguments
+} dll_trace_op_t;
+
+typedef struct {
+    const dll_trace_op_t* op; // NULL when this call is not recorded
+    const void*           list;
+    uint64_t              size;
+    uint64_t              args[2];
+    uint64_t              start;
+} dll_trace_scope_t;
+
+extern atomic_bool dll_trace_on;
+
+dll_trace_scope_t
+dll_trace_scope_begin(const dll_trace_op_t* op, const dll_t* list, uint64_t arg0, uint64_t arg1);
+
+void
+dll_trace_scope_end(dll_trace_scope_t* scope);
+
+static inline dll_trace_scope_t
+dll_trace_begin(const dll_trace_op_t* op, const dll_t* list, const uint64_t arg0, const uint64_t arg1)
+{
+    if (!atomic_load_explicit(&dll_trace_on, memory_order_relaxed)) {
+        return (dll_trace_scope_t){ .op = NULL };
+    }
+    return dll_trace_scope_begin(op, list, arg0, arg1);
+}
+
+static inline void
+dll_trace_end(dll_trace_scope_t* scope)
+{
+    if (scope->op) {
+        dll_trace_scope_end(scope);
+    }
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+#define DLL_TRACE_ARGS(name, list, arg0_name, arg0, arg1_name, arg1)                     \
+    static const dll_trace_op_t dll_trace_op_ = { name, { arg0_name, arg1_name } };      \
+    __attribute__((cleanup(dll_trace_end))) dll_trace_scope_t dll_trace_scope_ =          \
+        dll_trace_begin(&dll_trace_op_, list, (uint64_t)(arg0), (uint64_t)(arg1))
+#else
+#define DLL_TRACE_ARGS(name, list, arg0_name, arg0, arg1_name, arg1) ((void)0)
+#endif
+
+#define DLL_TRACE(name, list) DLL_TRACE_ARGS(name, list, NULL, 0, NULL, 0)
+
+#endif /* DOUBLYLINKEDLIST_INTERNAL_H_ */
@@ -0,0 +1,267 @@
+#ifndef DOUBLYLINKEDLIST_INTRUSIVE_H_
+#define DOUBLYLINKEDLIST_INTRUSIVE_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Intrusive doubly linked list: the links live inside the user's own objects (a dll_hook_t member),
+ * so linking and unlinking never allocate and an object can be removed in O(1) without searching.
+ * An object can sit on as many lists at once as it has hooks.
+ *
+ * The list is circular around a sentinel hook embedded in dll_ilist_t, so no operation needs to
+ * branch on the ends of the list.
+ */
+
+typedef struct dll_hook_type {
+    struct dll_hook_type* next;
+    struct dll_hook_type* prev;
+} dll_hook_t;
+
+typedef struct dll_ilist_type {
+    dll_hook_t head;
+    size_t     count;
+} dll_ilist_t;
+
+/**
+ * @brief Get a pointer to the object embedding a hook.
+ *
+ * @param ptr    Pointer to the hook.
+ * @param type   Type of the embedding object.
+ * @param member Name of the dll_hook_t member in @p type.
+ *
+ * @return Pointer to the object of type @p type containing @p ptr.
+ */
+#define dll_container_of(ptr, type, member) \
+    ((type*)((char*)(ptr) - offsetof(type, member)))
+
+/**
+ * @brief Iterate over all hooks in the list, from first to last.
+ *        The current hook must not be removed in the body of the loop.
+ *
+ * @param list List.
+ * @param it   dll_hook_t* variable used as the cursor.
+ */
+#define dll_ilist_foreach(list, it) \
+    for ((it) = (list)->head.next; (it) != &(list)->head; (it) = (it)->next)
+
+/**
+ * @brief Initialize an empty intrusive list.
+ *
+ * @param list List.
+ */
+static inline void
+dll_ilist_init(dll_ilist_t* list)
+{
+    list->head.next = list->head.prev = &list->head;
+    list->count     = 0;
+}
+
+/**
+ * @brief Initialize a hook as unlinked. Must be called before the hook is first used.
+ *
+ * @param hook Hook.
+ */
+static inline void
+dll_hook_init(dll_hook_t* hook)
+{
+    hook->next = hook->prev = NULL;
+}
+
+/**
+ * @brief Test whether a hook is currently linked into a list.
+ *
+ * @param hook Hook.
+ *
+ * @return True if linked.
+ */
+static inline bool
+dll_hook_is_linked(const dll_hook_t* hook)
+{
+    return hook->next != NULL;
+}
+
+/**
+ * @brief Test whether the list is empty.
+ *
+ * @param list List.
+ *
+ * @return True if empty.
+ */
+static inline bool
+dll_ilist_is_empty(const dll_ilist_t* list)
+{
+    return !list->count;
+}
+
+/**
+ * @brief Get the number of linked hooks.
+ *
+ * @param list List.
+ *
+ * @return Element count.
+ */
+static inline size_t
+dll_ilist_count(const dll_ilist_t* list)
+{
+    return list->count;
+}
+
+/**
+ * @brief Link @p hook right after @p pos, which is either linked in @p list or its sentinel.
+ *
+ * @param list List.
+ * @param pos  Hook after which to insert.
+ * @param hook Unlinked hook to insert.
+ */
+static inline void
+dll_ilist_insert_after(dll_ilist_t* list, dll_hook_t* pos, dll_hook_t* hook)
+{
+    hook->prev      = pos;
+    hook->next      = pos->next;
+    pos->next->prev = hook;
+    pos->next       = hook;
+    list->count++;
+}
+
+/**
+ * @brief Link @p hook right before @p pos, which is either linked in @p list or its sentinel.
+ *
+ * @param list List.
+ * @param pos  Hook before which to insert.
+ * @param hook Unlinked hook to insert.
+ */
+static inline void
+dll_ilist_insert_before(dll_ilist_t* list, dll_hook_t* pos, dll_hook_t* hook)
+{
+    dll_ilist_insert_after(list, pos->prev, hook);
+}
+
+/**
+ * @brief Link a hook at the beginning of the list.
+ *
+ * @param list List.
+ * @param hook Unlinked hook.
+ */
+static inline void
+dll_ilist_prepend(dll_ilist_t* list, dll_hook_t* hook)
+{
+    dll_ilist_insert_after(list, &list->head, hook);
+}
+
+/**
+ * @brief Link a hook at the end of the list.
+ *
+ * @param list List.
+ * @param hook Unlinked hook.
+ */
+static inline void
+dll_ilist_append(dll_ilist_t* list, dll_hook_t* hook)
+{
+    dll_ilist_insert_after(list, list->head.prev, hook);
+}
+
+/**
+ * @brief Unlink a hook from the list it belongs to. Runs in O(1).
+ *
+ * @param list List @p hook is linked in.
+ * @param hook Hook to unlink; it is left unlinked and may be reused.
+ */
+static inline void
+dll_ilist_remove(dll_ilist_t* list, dll_hook_t* hook)
+{
+    hook->prev->next = hook->next;
+    hook->next->prev = hook->prev;
+    dll_hook_init(hook);
+    list->count--;
+}
+
+/**
+ * @brief Get the first hook of the list.
+ *
+ * @param list List.
+ *
+ * @return First hook, or NULL if the list is empty.
+ */
+static inline dll_hook_t*
+dll_ilist_first(const dll_ilist_t* list)
+{
+    return list->count ? list->head.next : NULL;
+}
+
+/**
+ * @brief Get the last hook of the list.
+ *
+ * @param list List.
+ *
+ * @return Last hook, or NULL if the list is empty.
+ */
+static inline dll_hook_t*
+dll_ilist_last(const dll_ilist_t* list)
+{
+    return list->count ? list->head.prev : NULL;
+}
+
+/**
+ * @brief Get the hook following @p hook.
+ *
+ * @param list List @p hook is linked in.
+ * @param hook Hook.
+ *
+ * @return Next hook, or NULL if @p hook is the last one.
+ */
+static inline dll_hook_t*
+dll_ilist_next(const dll_ilist_t* list, const dll_hook_t* hook)
+{
+    return hook->next != &list->head ? hook->next : NULL;
+}
+
+/**
+ * @brief Get the hook preceding @p hook.
+ *
+ * @param list List @p hook is linked in.
+ * @param hook Hook.
+ *
+ * @return Previous hook, or NULL if @p hook is the first one.
+ */
+static inline dll_hook_t*
+dll_ilist_prev(const dll_ilist_t* list, const dll_hook_t* hook)
+{
+    return hook->prev != &list->head ? hook->prev : NULL;
+}
+
+/**
+ * @brief Unlink and return the first hook of the list.
+ *
+ * @param list List.
+ *
+ * @return Former first hook, or NULL if the list is empty.
+ */
+static inline dll_hook_t*
+dll_ilist_pop_first(dll_ilist_t* list)
+{
+    dll_hook_t* hook = dll_ilist_first(list);
+    if (hook) {
+        dll_ilist_remove(list, hook);
+    }
+    return hook;
+}
+
+/**
+ * @brief Unlink and return the last hook of the list.
+ *
+ * @param list List.
+ *
+ * @return Former last hook, or NULL if the list is empty.
+ */
+static inline dll_hook_t*
+dll_ilist_pop_last(dll_ilist_t* list)
+{
+    dll_hook_t* hook = dll_ilist_last(list);
+    if (hook) {
+        dll_ilist_remove(list, hook);
+    }
+    return hook;
+}
+
+#endif /* DOUBLYLINKEDLIST_INTRUSIVE_H_ */
@@ -0,0 +1,290 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "dll_parallel.h"
+#include "dll_internal.h"
+
+typedef void (*dll_job_fn_t)(void* ctx, size_t index);
+
+struct dll_thread_pool_type {
+    pthread_mutex_t lock;
+    pthread_cond_t  work; // Workers wait here for the next generation
+    pthread_cond_t  done; // The caller waits here for pending to drop to 0
+    pthread_mutex_t run;  // One job at a time
+    pthread_t*      threads;
+    size_t          size;
+    unsigned long   generation;
+    size_t          pending;
+    bool            stopping;
+    dll_job_fn_t    job;
+    void*           ctx;
+};
+
+typedef struct {
+    dll_thread_pool_t* pool;
+    size_t             index;
+} dll_worker_t;
+
+/* Half-open run of nodes [first, end) handled by one thread. */
+typedef struct {
+    dll_node_t* first;
+    dll_node_t* end;
+} dll_segment_t;
+
+static void*
+dll_worker_main(void* p)
+{
+    dll_worker_t       worker = *(dll_worker_t*)p;
+    dll_thread_pool_t* pool   = worker.pool;
+    unsigned long      seen   = 0;
+    free(p);
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->stopping && pool->generation == seen) {
+            pthread_cond_wait(&pool->work, &pool->lock);
+        }
+        if (pool->stopping)
+            break;
+        seen                   = pool->generation;
+        const dll_job_fn_t job = pool->job;
+        void*              ctx = pool->ctx;
+        pthread_mutex_unlock(&pool->lock);
+
+        job(ctx, worker.index);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0)
+            pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+dll_thread_pool_t*
+dll_thread_pool_create(size_t threads)
+{
+    if (threads == 0) {
+        const long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads           = online > 0 ? (size_t)online : 1;
+    }
+
+    dll_thread_pool_t* pool = malloc(sizeof *pool);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pthread_mutex_init(&pool->run, NULL);
+    pool->threads    = malloc(threads * sizeof *pool->threads);
+    pool->size       = threads;
+    pool->generation = 0;
+    pool->pending    = 0;
+    pool->stopping   = false;
+    pool->job        = NULL;
+    pool->ctx        = NULL;
+
+    for (size_t i = 0; i < threads; ++i) {
+        dll_worker_t* worker = malloc(sizeof *worker);
+        worker->pool         = pool;
+        worker->index        = i;
+        abort_unless(pthread_create(&pool->threads[i], NULL, dll_worker_main, worker) == 0);
+    }
+    return pool;
+}
+
+void
+dll_thread_pool_destroy(dll_thread_pool_t* pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < pool->size; ++i) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_mutex_destroy(&pool->run);
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->work);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool);
+}
+
+size_t
+dll_thread_pool_size(const dll_thread_pool_t* pool)
+{
+    return pool->size;
+}
+
+/* Run job(ctx, i) on every thread i of the pool, returning once all of them are done. */
+static void
+dll_thread_pool_run(dll_thread_pool_t* pool, dll_job_fn_t job, void* ctx)
+{
+    pthread_mutex_lock(&pool->run);
+    pthread_mutex_lock(&pool->lock);
+    pool->job     = job;
+    pool->ctx     = ctx;
+    pool->pending = pool->size;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work);
+    while (pool->pending) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    pthread_mutex_unlock(&pool->run);
+}
+
+/*
+ * Cut the list into @p n segments whose lengths differ by at most one. Cuts in the first half are found
+ * walking from the head, the others walking from the tail, so only half of the list is visited.
+ */
+static dll_segment_t*
+dll_segments(const dll_t* list, const size_t n)
+{
+    dll_segment_t* segments = malloc(n * sizeof *segments);
+    // cuts[i] is the first node of segment i, cuts[n] the tail
+    dll_node_t** cuts = malloc((n + 1) * sizeof *cuts);
+
+    cuts[n] = list->tail;
+    size_t      pos  = 0;
+    dll_node_t* node = list->head->next;
+    size_t      i    = 0;
+    for (; i < n && list->count * i / n <= list->count / 2; ++i) {
+        for (const size_t target = list->count * i / n; pos < target; ++pos) {
+            node = node->next;
+        }
+        cuts[i] = node;
+    }
+    pos  = list->count;
+    node = list->tail;
+    for (size_t j = n; j-- > i;) {
+        for (const size_t target = list->count * j / n; pos > target; --pos) {
+            node = node->prev;
+        }
+        cuts[j] = node;
+    }
+
+    for (size_t k = 0; k < n; ++k) {
+        segments[k].first = cuts[k];
+        segments[k].end   = cuts[k + 1];
+    }
+    free(cuts);
+    return segments;
+}
+
+typedef struct {
+    dll_segment_t*   segments;
+    dll_foreach_fn_t fn;
+    char*            args;
+    size_t           arg_size;
+} dll_foreach_job_t;
+
+static void
+dll_foreach_segment(void* ctx, const size_t index)
+{
+    const dll_foreach_job_t* job     = ctx;
+    void*                    arg     = job->args + index * job->arg_size;
+    dll_node_t*              current = job->segments[index].first;
+    dll_node_t*              end     = job->segments[index].end;
+    dll_prefetcher_t         pf;
+
+    dll_prefetcher_init(&pf, current, end);
+    while (current != end) {
+        dll_prefetcher_step(&pf);
+        job->fn(current->data, arg);
+        current = current->next;
+    }
+}
+
+void
+dll_foreach_parallel(const dll_t* list, dll_thread_pool_t* pool, dll_foreach_fn_t fn, void* args,
+                     const size_t arg_size)
+{
+    /* Function must be provided (otherwise, what's the point of this function? :)) */
+    abort_unless(fn);
+
+    if (list->count == 0) {
+        return;
+    }
+
+    dll_foreach_job_t job = {
+        .segments = dll_segments(list, pool->size),
+        .fn       = fn,
+        .args     = args,
+        .arg_size = arg_size,
+    };
+    dll_thread_pool_run(pool, dll_foreach_segment, &job);
+    free(job.segments);
+}
+
+typedef struct {
+    dll_segment_t*  segments;
+    dll_node_t**    matches;
+    dll_find_fn_t   fn;
+    void*           arg;
+    dll_find_mode_t mode;
+    // Lowest segment with a match so far (SIZE_MAX: none)
+    atomic_size_t   found;
+} dll_find_job_t;
+
+static void
+dll_find_segment(void* ctx, const size_t index)
+{
+    dll_find_job_t*  job     = ctx;
+    dll_node_t*      current = job->segments[index].first;
+    dll_node_t*      end     = job->segments[index].end;
+    dll_prefetcher_t pf;
+
+    // First mode: a match in an earlier segment makes this one pointless. Any mode: any match does.
+    const size_t stop_below = job->mode == DLL_FIND_FIRST ? index : SIZE_MAX;
+
+    job->matches[index] = NULL;
+    dll_prefetcher_init(&pf, current, end);
+    while (current != end) {
+        if (atomic_load_explicit(&job->found, memory_order_relaxed) < stop_below)
+            return;
+        dll_prefetcher_step(&pf);
+        if (job->fn(current->data, job->arg)) {
+            job->matches[index] = current;
+            size_t found        = atomic_load(&job->found);
+            while (index < found && !atomic_compare_exchange_weak(&job->found, &found, index)) {
+            }
+            return;
+        }
+        current = current->next;
+    }
+}
+
+dll_node_t*
+dll_find_parallel(const dll_t* list, dll_thread_pool_t* pool, dll_find_fn_t fn, void* arg,
+                  const dll_find_mode_t mode)
+{
+    /* Searching function must be provided (otherwise, what's the point of this function? :)) */
+    abort_unless(fn);
+
+    if (list->count == 0) {
+        return NULL;
+    }
+
+    dll_find_job_t job = {
+        .segments = dll_segments(list, pool->size),
+        .matches  = malloc(pool->size * sizeof(dll_node_t*)),
+        .fn       = fn,
+        .arg      = arg,
+        .mode     = mode,
+    };
+    atomic_init(&job.found, SIZE_MAX);
+    dll_thread_pool_run(pool, dll_find_segment, &job);
+
+    const size_t found = atomic_load(&job.found);
+    dll_node_t*  match = found == SIZE_MAX ? NULL : job.matches[found];
+    free(job.matches);
+    free(job.segments);
+    return match;
+}
@@ -0,0 +1,81 @@
+#ifndef DOUBLYLINKEDLIST_PARALLEL_H_
+#define DOUBLYLINKEDLIST_PARALLEL_H_
+
+#include <stddef.h>
+
+#include "dll.h"
+
+/*
+ * Parallel traversals of dll_t on a reusable pool of pthreads. The list is cut into one segment of
+ * (nearly) equal length per thread; finding the cuts walks half the list once, so these pay off when the
+ * callbacks cost more than following a pointer. The list must not be modified while a traversal runs.
+ * A pool runs one traversal at a time: concurrent calls on the same pool are serialized.
+ */
+
+typedef struct dll_thread_pool_type dll_thread_pool_t;
+
+typedef enum {
+    DLL_FIND_FIRST = 0, // The match closest to the head of the list
+    DLL_FIND_ANY,       // Whichever match is seen first; stops all threads as soon as there is one
+} dll_find_mode_t;
+
+/**
+ * @brief Create a pool of threads.
+ *
+ * @param threads Number of threads (0 means one per online CPU).
+ *
+ * @return Thread pool.
+ */
+dll_thread_pool_t*
+dll_thread_pool_create(size_t threads);
+
+/**
+ * @brief Stop and join the threads of a pool, then free it. No traversal may be running on it.
+ *
+ * @param pool Thread pool.
+ */
+void
+dll_thread_pool_destroy(dll_thread_pool_t* pool);
+
+/**
+ * @brief Get the number of threads of a pool, which is also the number of segments lists are cut into.
+ *
+ * @param pool Thread pool.
+ *
+ * @return Thread count.
+ */
+size_t
+dll_thread_pool_size(const dll_thread_pool_t* pool);
+
+/**
+ * @brief Apply a function to all elements in the list, in parallel. Each segment is visited in order by a
+ *        single thread, which hands @p fn its own argument: reductions can accumulate into it without locks,
+ *        and the caller combines the per-thread results afterwards.
+ *
+ * @param list     List.
+ * @param pool     Thread pool.
+ * @param fn       Function to apply to the elements (must be provided).
+ * @param args     Array of dll_thread_pool_size() arguments, @p arg_size bytes each, one per thread; or a single
+ *                 argument shared by all threads if @p arg_size is 0. Padding each argument to a cache line
+ *                 (64 bytes) keeps threads from slowing each other down through false sharing.
+ * @param arg_size Size of each argument in @p args, in bytes.
+ */
+void
+dll_foreach_parallel(const dll_t* list, dll_thread_pool_t* pool, dll_foreach_fn_t fn, void* args,
+                     size_t arg_size);
+
+/**
+ * @brief Find an element matching the search criteria given with a custom function, in parallel.
+ *
+ * @param list List.
+ * @param pool Thread pool.
+ * @param fn   Search function (must be provided), called concurrently from several threads.
+ * @param arg  Argument sent to @p fn, shared by all threads.
+ * @param mode Whether the first match is wanted, or any match will do.
+ *
+ * @return Pointer to the matching node, or NULL if no such element was found.
+ */
+dll_node_t*
+dll_find_parallel(const dll_t* list, dll_thread_pool_t* pool, dll_find_fn_t fn, void* arg, dll_find_mode_t mode);
+
+#endif /* DOUBLYLINKEDLIST_PARALLEL_H_ */
@@ -0,0 +1,248 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "dll_trace.h"
+#include "dll_internal.h"
+
+typedef struct {
+    const dll_trace_op_t* op;
+    const void*           list;
+    uint64_t              size;
+    uint64_t              args[2];
+    uint64_t              start;
+    uint64_t              end;
+} dll_trace_event_t;
+
+/*
+ * One per thread that recorded something. When its thread exits, a ring is retired rather than freed: dumps still
+ * see the events of finished threads. Past DLL_TRACE_KEPT_RINGS retired rings, new threads take over the oldest.
+ */
+typedef struct dll_trace_ring_type {
+    dll_trace_event_t           events[DLL_TRACE_CAPACITY];
+    atomic_size_t               written; // Events ever recorded; the last DLL_TRACE_CAPACITY are kept
+    atomic_size_t               cleared; // Events recorded before the last dll_trace_clear(), never dumped
+    unsigned                    tid;
+    uint64_t                    retired; // When its thread exited (in ring retirements), 0 while in use
+    struct dll_trace_ring_type* next;
+} dll_trace_ring_t;
+
+atomic_bool dll_trace_on = false;
+
+static _Thread_local dll_trace_ring_t* dll_trace_ring;
+// Set while a traced call runs, so the calls it makes are not recorded
+static _Thread_local bool dll_trace_busy;
+
+static pthread_mutex_t   dll_trace_lock        = PTHREAD_MUTEX_INITIALIZER;
+static dll_trace_ring_t* dll_trace_rings       = NULL;
+static unsigned          dll_trace_tids        = 0;
+static uint64_t          dll_trace_retirements = 0;
+
+// Its destructor retires the ring of an exiting thread
+static pthread_key_t  dll_trace_key;
+static pthread_once_t dll_trace_key_once = PTHREAD_ONCE_INIT;
+
+// Clock reading and time (ns) when tracing was first enabled, to convert clock ticks into microseconds
+static uint64_t dll_trace_epoch_ticks;
+static uint64_t dll_trace_epoch_ns;
+
+static uint64_t
+dll_trace_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* The time stamp counter where there is one: a few cycles instead of a clock_gettime() call. */
+static inline uint64_t
+dll_trace_ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return dll_trace_ns();
+#endif
+}
+
+void
+dll_trace_enable(void)
+{
+    pthread_mutex_lock(&dll_trace_lock);
+    if (!dll_trace_epoch_ns) {
+        dll_trace_epoch_ns    = dll_trace_ns();
+        dll_trace_epoch_ticks = dll_trace_ticks();
+    }
+    pthread_mutex_unlock(&dll_trace_lock);
+    atomic_store(&dll_trace_on, true);
+}
+
+void
+dll_trace_disable(void)
+{
+    atomic_store(&dll_trace_on, false);
+}
+
+bool
+dll_trace_enabled(void)
+{
+    return atomic_load(&dll_trace_on);
+}
+
+void
+dll_trace_clear(void)
+{
+    // Only the owner thread writes a ring's count: clearing moves the dump's starting point instead
+    pthread_mutex_lock(&dll_trace_lock);
+    for (dll_trace_ring_t* ring = dll_trace_rings; ring; ring = ring->next) {
+        atomic_store(&ring->cleared, atomic_load(&ring->written));
+    }
+    pthread_mutex_unlock(&dll_trace_lock);
+}
+
+/* Runs in the exiting thread. Were it to record again (from another destructor), it would take a new ring. */
+static void
+dll_trace_ring_retire(void* ring)
+{
+    dll_trace_ring = NULL;
+    pthread_mutex_lock(&dll_trace_lock);
+    ((dll_trace_ring_t*)ring)->retired = ++dll_trace_retirements;
+    pthread_mutex_unlock(&dll_trace_lock);
+}
+
+static void
+dll_trace_key_create(void)
+{
+    abort_unless(pthread_key_create(&dll_trace_key, dll_trace_ring_retire) == 0);
+}
+
+static dll_trace_ring_t*
+dll_trace_ring_create(void)
+{
+    pthread_once(&dll_trace_key_once, dll_trace_key_create);
+
+    pthread_mutex_lock(&dll_trace_lock);
+    size_t            retired = 0;
+    dll_trace_ring_t* oldest  = NULL;
+    for (dll_trace_ring_t* ring = dll_trace_rings; ring; ring = ring->next) {
+        if (ring->retired) {
+            ++retired;
+            if (!oldest || ring->retired < oldest->retired) {
+                oldest = ring;
+            }
+        }
+    }
+
+    dll_trace_ring_t* ring = NULL;
+    if (retired >= DLL_TRACE_KEPT_RINGS) {
+        // Taken over: the events of its finished thread are dropped
+        ring          = oldest;
+        ring->retired = 0;
+        atomic_store(&ring->written, 0);
+        atomic_store(&ring->cleared, 0);
+    }
+    else {
+        ring = malloc(sizeof *ring);
+        abort_unless(ring);
+        atomic_init(&ring->written, 0);
+        atomic_init(&ring->cleared, 0);
+        ring->retired   = 0;
+        ring->next      = dll_trace_rings;
+        dll_trace_rings = ring;
+    }
+    ring->tid = ++dll_trace_tids;
+    pthread_mutex_unlock(&dll_trace_lock);
+
+    pthread_setspecific(dll_trace_key, ring);
+    return ring;
+}
+
+dll_trace_scope_t
+dll_trace_scope_begin(const dll_trace_op_t* op, const dll_t* list, const uint64_t arg0, const uint64_t arg1)
+{
+    if (dll_trace_busy) {
+        return (dll_trace_scope_t){ .op = NULL };
+    }
+    dll_trace_busy = true;
+    return (dll_trace_scope_t){
+        .op    = op,
+        .list  = list,
+        .size  = list ? list->count : 0,
+        .args  = { arg0, arg1 },
+        .start = dll_trace_ticks(),
+    };
+}
+
+void
+dll_trace_scope_end(dll_trace_scope_t* scope)
+{
+    const uint64_t end = dll_trace_ticks();
+    dll_trace_busy     = false;
+
+    dll_trace_ring_t* ring = dll_trace_ring;
+    if (!ring) {
+        ring = dll_trace_ring = dll_trace_ring_create();
+    }
+
+    // Single writer: fill the slot, then publish it
+    const size_t       written = atomic_load_explicit(&ring->written, memory_order_relaxed);
+    dll_trace_event_t* event   = &ring->events[written % DLL_TRACE_CAPACITY];
+    event->op                  = scope->op;
+    event->list                = scope->list;
+    event->size                = scope->size;
+    event->args[0]             = scope->args[0];
+    event->args[1]             = scope->args[1];
+    event->start               = scope->start;
+    event->end                 = end;
+    atomic_store_explicit(&ring->written, written + 1, memory_order_release);
+}
+
+bool
+dll_trace_dump(FILE* out)
+{
+    pthread_mutex_lock(&dll_trace_lock);
+
+    // Clock ticks per microsecond, measured over the time tracing has been on
+    const uint64_t ns    = dll_trace_ns() - dll_trace_epoch_ns;
+    const uint64_t ticks = dll_trace_ticks() - dll_trace_epoch_ticks;
+    const double   scale = ns && ticks ? (double)ticks / ns * 1000.0 : 1000.0;
+    const long     pid   = (long)getpid();
+
+    bool first = true;
+    fputs("{\"traceEvents\":[", out);
+    for (const dll_trace_ring_t* ring = dll_trace_rings; ring; ring = ring->next) {
+        const size_t written = atomic_load_explicit(&ring->written, memory_order_acquire);
+        const size_t cleared = atomic_load(&ring->cleared);
+        size_t       i       = written > DLL_TRACE_CAPACITY ? written - DLL_TRACE_CAPACITY : 0;
+        for (i = i > cleared ? i : cleared; i < written; ++i) {
+            const dll_trace_event_t* event = &ring->events[i % DLL_TRACE_CAPACITY];
+            fprintf(out,
+                    "%s\n{\"name\":\"%s\",\"cat\":\"dll\",\"ph\":\"X\",\"pid\":%ld,\"tid\":%u,\"ts\":%.3f,"
+                    "\"dur\":%.3f,\"args\":{\"list\":\"%p\",\"size\":%" PRIu64,
+                    first ? "" : ",", event->op->name, pid, ring->tid,
+                    (double)(event->start - dll_trace_epoch_ticks) / scale,
+                    (double)(event->end - event->start) / scale, event->list, event->size);
+            for (int arg = 0; arg < 2; ++arg) {
+                if (event->op->arg_names[arg]) {
+                    fprintf(out, ",\"%s\":%" PRIu64, event->op->arg_names[arg], event->args[arg]);
+                }
+            }
+            fputs("}}", out);
+            first = false;
+        }
+    }
+    fputs("\n]}\n", out);
+
+    pthread_mutex_unlock(&dll_trace_lock);
+    return !ferror(out);
+}
@@ -0,0 +1,64 @@
+#ifndef DOUBLYLINKEDLIST_TRACE_H_
+#define DOUBLYLINKEDLIST_TRACE_H_
+
+#include <stdbool.h>
+#include <stdio.h>
+
+/*
+ * Operation tracing. While enabled, every call to the dll_* functions of dll.h (but the O(1) getters) records
+ * an event: function, list, list size when called, positions involved, start time and duration. Calls made
+ * by a traced function on its own are not recorded separately. Events go to a ring buffer of the calling
+ * thread, written without locks or atomic read-modify-writes; each ring keeps the last DLL_TRACE_CAPACITY
+ * events of its thread. dll_trace_dump() exports all rings as Chrome trace-event JSON, to be opened with
+ * chrome://tracing or https://ui.perfetto.dev.
+ *
+ * A ring outlives its thread, so that dumps still show what finished threads did. Once DLL_TRACE_KEPT_RINGS rings
+ * of finished threads are kept, a new thread takes over the oldest of them: memory stays bounded by the threads
+ * alive plus that many rings, even when threads come and go per task.
+ *
+ * When disabled, tracing costs a relaxed atomic load per call. Tracing needs GCC or Clang (it relies on
+ * the cleanup attribute); with other compilers nothing is recorded.
+ */
+
+#define DLL_TRACE_CAPACITY 16384
+#define DLL_TRACE_KEPT_RINGS 8
+
+/**
+ * @brief Start recording events, from every thread.
+ */
+void
+dll_trace_enable(void);
+
+/**
+ * @brief Stop recording events. Calls already running still record theirs.
+ */
+void
+dll_trace_disable(void);
+
+/**
+ * @brief Check whether events are being recorded.
+ *
+ * @return true if tracing is enabled, false otherwise.
+ */
+bool
+dll_trace_enabled(void);
+
+/**
+ * @brief Drop the events recorded so far, in every thread. Safe while other threads record events: those
+ *        recorded during the call may be dropped or kept.
+ */
+void
+dll_trace_clear(void);
+
+/**
+ * @brief Write the recorded events as Chrome trace-event JSON. Dumping while other threads record events
+ *        may show some of their events half-written: disable tracing first for an exact dump.
+ *
+ * @param out Stream to write to.
+ *
+ * @return true on success, false if writing failed.
+ */
+bool
+dll_trace_dump(FILE* out);
+
+#endif /* DOUBLYLINKEDLIST_TRACE_H_ */
@@ -17,10 +17,17 @@
  */
 
 #include <assert.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "dll.h"
+#include "dll_alloc.h"
+#include "dll_channel.h"
+#include "dll_intrusive.h"
+#include "dll_parallel.h"
+#include "dll_trace.h"
 
 #define NR_ELEMS 20
 
@@ -58,6 +65,105 @@ list_cmp_fn(const void* elem_, void* arg)
     return current == target;
 }
 
+static int
+int_cmp(const void* a, const void* b, void* arg)
+{
+    (void)arg;
+    const int x = *(const int*)a;
+    const int y = *(const int*)b;
+
+    return (x > y) - (x < y);
+}
+
+static size_t freed_in_batches;
+
+static void
+free_batch(void** data, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        free(data[i]);
+    }
+    freed_in_batches += count;
+}
+
+// An object that can sit on two intrusive lists at once
+typedef struct {
+    int        value;
+    dll_hook_t all;
+    dll_hook_t odd;
+} tracked_t;
+
+#define CHANNEL_ITEMS 10000
+
+static void*
+channel_producer(void* arg)
+{
+    static int    values[CHANNEL_ITEMS];
+    dll_channel_t* channel = arg;
+    void*          batch[16];
+
+    for (size_t i = 0; i < CHANNEL_ITEMS; i += 16) {
+        for (size_t j = 0; j < 16; ++j) {
+            values[i + j] = 1;
+            batch[j]      = &values[i + j];
+        }
+        dll_channel_push_batch(channel, batch, 16, DLL_CHANNEL_WAIT_FOREVER);
+    }
+    dll_channel_close(channel);
+    return NULL;
+}
+
+/* Creates a list of one element, registered from a thread of its own. */
+static void*
+registered_list(void* arg)
+{
+    dll_t* list = dll_create();
+    dll_append(list, arg);
+    return list;
+}
+
+/* Records one traced call, from a thread of its own. */
+static void*
+trace_worker(void* arg)
+{
+    dll_t* list = dll_create();
+    dll_append(list, arg);
+    dll_destroy(list, NULL);
+    return NULL;
+}
+
+/* Number of events in a trace dump. */
+static size_t
+trace_events(void)
+{
+    FILE* json = tmpfile();
+    expect(dll_trace_dump(json), true);
+    rewind(json);
+    char   trace[8192];
+    size_t events = 0;
+    while (fgets(trace, sizeof trace, json)) {
+        events += strstr(trace, "\"ph\":\"X\"") != NULL;
+    }
+    fclose(json);
+    return events;
+}
+
+static void*
+channel_consumer(void* arg)
+{
+    dll_channel_t* channel = arg;
+    void*          batch[7];
+    size_t         n       = 0;
+    long           sum     = 0;
+
+    while ((n = dll_channel_pop_batch(channel, batch, 7, DLL_CHANNEL_WAIT_FOREVER)) > 0) {
+        for (size_t i = 0; i < n; ++i) {
+            sum += *(int*)batch[i];
+        }
+    }
+    return (void*)sum;
+}
+
 int
 main(int argc, char* argv[])
 {
@@ -183,5 +289,364 @@ main(int argc, char* argv[])
     dll_destroy(new_list, free);
     free(array);
 
+    // contiguous list: elements live in the list's own blocks
+    int    block_array[] = {5, 6, 7, 8};
+    dll_t* block_list    = dll_from_array_block(block_array, 4, sizeof(int));
+    block_array[0]       = 0;
+    expect(dll_count(block_list), 4);
+    expect(*(int*)dll_peek_at(block_list, 0), 5);
+    expect(*(int*)dll_extract_at(block_list, 1), 6);
+    expect(*(int*)dll_peek_at(block_list, 2), 8);
+    // mixed with a regular element: only that one is handed to free()
+    int* heap_elem = malloc(sizeof *heap_elem);
+    *heap_elem     = 9;
+    dll_append(block_list, heap_elem);
+    expect(dll_count(block_list), 4);
+    expect(*(int*)dll_peek_at(block_list, 3), 9);
+    dll_destroy(block_list, free);
+
+    // deque-style use, and swaps found from either end
+    int    deque_vals[] = {0, 1, 2, 3, 4, 5, 6, 7};
+    dll_t* deque        = dll_create();
+    expect(dll_peek_first(deque), NULL);
+    expect(dll_extract_last(deque), NULL);
+    for (int i = 0; i < 8; ++i) {
+        dll_append(deque, &deque_vals[i]);
+    }
+    expect(*(int*)dll_peek_first(deque), 0);
+    expect(*(int*)dll_peek_last(deque), 7);
+    expect(*(int*)dll_peek_at(deque, 6), 6);
+    expect(dll_swap(deque, 6, 7), true); // from the tail
+    expect(dll_swap(deque, 1, 3), true); // from the head
+    expect(dll_swap(deque, 0, 7), true); // from both ends
+    expect(*(int*)dll_peek_at(deque, 0), 6);
+    expect(*(int*)dll_peek_at(deque, 1), 3);
+    expect(*(int*)dll_peek_at(deque, 3), 1);
+    expect(*(int*)dll_peek_at(deque, 6), 7);
+    expect(*(int*)dll_extract_last(deque), 0);
+    expect(*(int*)dll_extract_first(deque), 6);
+    expect(*(int*)dll_peek_last(deque), 7);
+    expect(dll_count(deque), 6);
+    // exports without allocation: into a buffer, a range, gathered pointers, a reused buffer
+    // deque contains now the following values: {3 2 1 4 5 7}
+    int    exported[8];
+    void*  gathered[8];
+    void*  reused          = NULL;
+    size_t reused_capacity = 0;
+    expect(dll_to_array_into(deque, exported, 4, sizeof(int)), 4);
+    expect(exported[3], 4);
+    expect(dll_to_array_range(deque, 4, 8, exported, sizeof(int)), 2);
+    expect(exported[0] + exported[1], 12);
+    expect(dll_to_array_range(deque, 6, 1, exported, sizeof(int)), 0);
+    expect(dll_gather(deque, gathered, 8), 6);
+    expect(gathered[5], &deque_vals[7]);
+    expect(dll_to_array_reuse(deque, sizeof(int), &reused, &reused_capacity), 6);
+    void* first_buffer = reused;
+    dll_extract_last(deque);
+    expect(dll_to_array_reuse(deque, sizeof(int), &reused, &reused_capacity), 5);
+    expect(reused, first_buffer);
+    expect(((int*)reused)[4], 5);
+    free(reused);
+    dll_destroy(deque, NULL);
+
+    dll_t* empty = dll_create();
+    array_size   = 1;
+    expect(dll_to_array(empty, sizeof(int), &array_size), NULL);
+    expect(array_size, 0);
+    dll_destroy(empty, NULL);
+
+    // typed list: elements are copied into the nodes
+    typedef struct {
+        int    id;
+        double weight;
+    } sample_t;
+    dll_t*    typed  = dll_create_typed(sizeof(sample_t));
+    sample_t  sample = {2, 0.5};
+    sample_t* stored = dll_append_copy(typed, &sample);
+    sample.id = 3;
+    dll_append_copy(typed, &sample);
+    sample.id = 1;
+    dll_prepend_copy(typed, &sample);
+    stored->weight = 2.5;
+    expect(dll_elem_size(typed), sizeof(sample_t));
+    expect(((sample_t*)dll_peek_at(typed, 1))->weight, 2.5);
+    dll_t*    typed_clone  = dll_clone(typed);
+    size_t    samples_size = 0;
+    sample_t* samples      = dll_to_array(typed, sizeof(sample_t), &samples_size);
+    expect(samples_size, 3);
+    expect(samples[0].id + samples[1].id + samples[2].id, 6);
+    expect(dll_extract_at_into(typed, 0, &sample), true);
+    expect(sample.id, 1);
+    expect(dll_extract_at_into(typed, 5, &sample), false);
+    expect(dll_count(typed), 2);
+    expect(((sample_t*)dll_peek_at(typed_clone, 0))->id, 1);
+    free(samples);
+    dll_destroy(typed_clone, NULL);
+    dll_destroy(typed, NULL);
+
+    // custom allocators: a pool of typed nodes, and an arena
+    dll_node_pool_t* pool        = dll_node_pool_create(sizeof(int));
+    dll_allocator_t  pool_alloc  = dll_node_pool_allocator(pool);
+    dll_t*           pooled      = dll_create_with_allocator(sizeof(int), &pool_alloc);
+    int              pooled_elem = 0;
+    for (; pooled_elem < 600; ++pooled_elem) {
+        dll_append_copy(pooled, &pooled_elem);
+    }
+    expect(dll_extract_at_into(pooled, 599, &pooled_elem), true);
+    expect(pooled_elem, 599);
+    dll_t* pooled_clone = dll_clone(pooled);
+    expect(*(int*)dll_peek_last(pooled_clone), 598);
+    dll_destroy(pooled_clone, NULL);
+    // emptied in one splice: the nodes go back to the pool in list order
+    void* first_slot = dll_peek_first(pooled);
+    dll_empty(pooled, NULL);
+    expect(dll_count(pooled), 0);
+    expect(dll_append_copy(pooled, &pooled_elem), first_slot);
+    dll_destroy(pooled, NULL);
+    dll_node_pool_destroy(pool);
+
+    dll_arena_t*    arena       = dll_arena_create(256);
+    dll_allocator_t arena_alloc = dll_arena_allocator(arena);
+    dll_t*          arena_list  = dll_create_with_allocator(0, &arena_alloc);
+    for (int i = 0; i < 5; ++i) {
+        dll_append(arena_list, &deque_vals[i]);
+    }
+    expect(*(int*)dll_extract_first(arena_list), 0);
+    expect(*(int*)dll_peek_at(arena_list, 3), 4);
+    dll_destroy(arena_list, NULL);
+    dll_arena_reset(arena);
+    dll_arena_destroy(arena);
+
+    // parallel traversals: per-thread sums, first and any match
+    dll_thread_pool_t* workers     = dll_thread_pool_create(3);
+    dll_t*             big         = dll_create_typed(sizeof(int));
+    int                partials[3] = {0, 0, 0};
+    int                big_target  = 7;
+    for (int i = 0; i < 1000; ++i) {
+        const int value = i % 10;
+        dll_append_copy(big, &value);
+    }
+    dll_foreach_parallel(big, workers, list_foreach_fn, partials, sizeof(int));
+    expect(partials[0] + partials[1] + partials[2], 4500);
+    const dll_node_t* first_seven = dll_find(big, list_cmp_fn, &big_target);
+    expect(dll_find_parallel(big, workers, list_cmp_fn, &big_target, DLL_FIND_FIRST), first_seven);
+    expect(*(int*)dll_node_peek(dll_find_parallel(big, workers, list_cmp_fn, &big_target, DLL_FIND_ANY)), 7);
+    big_target = 10;
+    expect(dll_find_parallel(big, workers, list_cmp_fn, &big_target, DLL_FIND_ANY), NULL);
+    dll_destroy(big, NULL);
+    dll_thread_pool_destroy(workers);
+
+    // sorted lists: merge by relinking, set operations
+    const int evens[] = {0, 2, 4, 6, 8};
+    const int mixed[] = {1, 2, 3, 4};
+    dll_t*    sorted1 = dll_from_array_block(evens, 5, sizeof(int));
+    dll_t*    sorted2 = dll_create_typed(sizeof(int));
+    dll_t*    sorted3 = dll_create_typed(sizeof(int));
+    for (int i = 0; i < 4; ++i) {
+        dll_append_copy(sorted2, &mixed[i]);
+        dll_append_copy(sorted3, &evens[i]);
+    }
+    dll_t* both   = dll_set_intersection(sorted2, sorted3, int_cmp, NULL);
+    dll_t* either = dll_set_union(sorted2, sorted3, int_cmp, NULL);
+    dll_t* only   = dll_set_difference(sorted2, sorted3, int_cmp, NULL);
+    expect(dll_count(both), 2);
+    expect(*(int*)dll_peek_last(both), 4);
+    expect(dll_count(either), 6);
+    expect(*(int*)dll_peek_at(either, 3), 3);
+    expect(dll_count(only), 2);
+    expect(*(int*)dll_peek_last(only), 3);
+    expect(dll_includes(sorted2, both, int_cmp, NULL), true);
+    expect(dll_includes(sorted2, sorted3, int_cmp, NULL), false);
+    dll_destroy(both, NULL);
+    dll_destroy(either, NULL);
+    dll_destroy(only, NULL);
+    dll_merge(sorted3, sorted2, int_cmp, NULL);
+    expect(dll_count(sorted3), 8);
+    expect(dll_count(sorted2), 0);
+    int merged[8];
+    dll_to_array_into(sorted3, merged, 8, sizeof(int));
+    for (int i = 1; i < 8; ++i) {
+        expect((merged[i - 1] <= merged[i]), true);
+    }
+    // merging a list into itself, or an empty list, moves nothing: no
+    // checks on how they allocate
+    dll_merge(sorted1, sorted1, int_cmp, NULL);
+    dll_merge(sorted1, sorted2, int_cmp, NULL);
+    expect(dll_count(sorted1), 5);
+    dll_destroy(sorted3, NULL);
+    dll_destroy(sorted2, NULL);
+    // a block list merged into an empty one hands over its block too
+    dll_t* receiver = dll_create();
+    dll_merge(receiver, sorted1, int_cmp, NULL);
+    dll_destroy(sorted1, NULL);
+    expect(*(int*)dll_peek_last(receiver), 8);
+    dll_destroy(receiver, free);
+
+    // batched teardown
+    dll_t* owning = dll_create();
+    for (int i = 0; i < 600; ++i) {
+        int* elem = malloc(sizeof *elem);
+        *elem     = i;
+        dll_append(owning, elem);
+    }
+    freed_in_batches = 0;
+    dll_destroy_batch(owning, free_batch);
+    expect(freed_in_batches, 600);
+
+    // intrusive lists
+    tracked_t   objs[4];
+    dll_ilist_t all, odd;
+    dll_ilist_init(&all);
+    dll_ilist_init(&odd);
+    for (int i = 0; i < 4; ++i) {
+        objs[i].value = i;
+        dll_hook_init(&objs[i].all);
+        dll_hook_init(&objs[i].odd);
+        dll_ilist_append(&all, &objs[i].all);
+        if (i % 2) {
+            dll_ilist_prepend(&odd, &objs[i].odd);
+        }
+    }
+    expect(dll_ilist_count(&all), 4);
+    expect(dll_ilist_count(&odd), 2);
+    expect(dll_container_of(dll_ilist_first(&odd), tracked_t, odd)->value, 3);
+
+    // unlink object 1 from both lists, straight from the object
+    dll_ilist_remove(&all, &objs[1].all);
+    dll_ilist_remove(&odd, &objs[1].odd);
+    expect(dll_hook_is_linked(&objs[1].all), false);
+    expect(dll_ilist_count(&all), 3);
+
+    int         isum = 0;
+    dll_hook_t* hook = NULL;
+    dll_ilist_foreach(&all, hook) {
+        isum += dll_container_of(hook, tracked_t, all)->value;
+    }
+    expect(isum, 5);
+    expect(dll_container_of(dll_ilist_pop_last(&all), tracked_t, all)->value, 3);
+    expect(dll_container_of(dll_ilist_pop_first(&odd), tracked_t, odd)->value, 3);
+    expect(dll_ilist_pop_first(&odd), NULL);
+    expect(dll_ilist_is_empty(&odd), true);
+
+    // channels
+    dll_channel_t* channel = dll_channel_create(2);
+    void*          popped  = NULL;
+    expect(dll_channel_try_pop(channel, &popped), DLL_CHANNEL_TIMEOUT);
+    expect(dll_channel_push(channel, &nums[0]), DLL_CHANNEL_OK);
+    expect(dll_channel_try_push(channel, &nums[1]), DLL_CHANNEL_OK);
+    expect(dll_channel_push_timed(channel, &nums[2], 10), DLL_CHANNEL_TIMEOUT);
+    void* three[3] = {&nums[2], &nums[3], &nums[4]};
+    expect(dll_channel_push_batch(channel, three, 3, 0), 0);
+    expect(dll_channel_count(channel), 2);
+    expect(dll_channel_pop(channel, &popped), DLL_CHANNEL_OK);
+    expect(*(int*)popped, 13);
+    dll_channel_close(channel);
+    expect(dll_channel_push(channel, &nums[2]), DLL_CHANNEL_CLOSED);
+    // closed channels are drained before reporting it
+    expect(dll_channel_pop_batch(channel, three, 3, 0), 1);
+    expect(*(int*)three[0], 1);
+    expect(dll_channel_pop(channel, &popped), DLL_CHANNEL_CLOSED);
+    dll_channel_destroy(channel, NULL);
+
+    // one producer, two consumers, under contention
+    channel = dll_channel_create(64);
+    pthread_t producer, consumers[2];
+    void*     partial[2];
+    pthread_create(&consumers[0], NULL, channel_consumer, channel);
+    pthread_create(&consumers[1], NULL, channel_consumer, channel);
+    pthread_create(&producer, NULL, channel_producer, channel);
+    pthread_join(producer, NULL);
+    pthread_join(consumers[0], &partial[0]);
+    pthread_join(consumers[1], &partial[1]);
+    expect((long)partial[0] + (long)partial[1], CHANNEL_ITEMS);
+    dll_channel_destroy(channel, NULL);
+
+    // memory accounting: per list, and over all live lists
+    size_t             lists_before;
+    dll_memory_usage_t before = dll_memory_usage_total(&lists_before);
+    dll_t*             sized  = dll_create_typed(sizeof(int));
+    for (int i = 0; i < 10; ++i) {
+        dll_append_copy(sized, &i);
+    }
+    dll_memory_usage_t usage = dll_memory_usage(sized);
+    expect(usage.elements, 10);
+    expect(usage.payload_bytes, 10 * sizeof(int));
+    expect(usage.total_bytes,
+           usage.payload_bytes + usage.link_bytes + usage.sentinel_bytes + usage.slack_bytes);
+    expect(usage.slack_known, true);
+    size_t             lists_after;
+    dll_memory_usage_t after = dll_memory_usage_total(&lists_after);
+    expect(lists_after, lists_before + 1);
+    expect(after.total_bytes, before.total_bytes + usage.total_bytes);
+    dll_node_pool_t* sized_pool   = dll_node_pool_create(sizeof(int));
+    dll_allocator_t  sized_alloc  = dll_node_pool_allocator(sized_pool);
+    dll_t*           sized_pooled = dll_create_with_allocator(sizeof(int), &sized_alloc);
+    dll_append_copy(sized_pooled, &nums[0]);
+    expect(dll_memory_usage(sized_pooled).link_bytes, usage.link_bytes / 10);
+    dll_destroy(sized_pooled, NULL);
+    dll_node_pool_destroy(sized_pool);
+    dll_destroy(sized, NULL);
+    expect(dll_memory_usage_total(NULL).total_bytes, before.total_bytes);
+    // Lists registered by other threads count too, and may be destroyed anywhere
+    pthread_t registrars[3];
+    void*     registered[3];
+    for (int i = 0; i < 3; ++i) {
+        pthread_create(&registrars[i], NULL, registered_list, &nums[i]);
+    }
+    for (int i = 0; i < 3; ++i) {
+        pthread_join(registrars[i], &registered[i]);
+    }
+    expect(dll_memory_usage_total(&lists_after).elements, before.elements + 3);
+    expect(lists_after, lists_before + 3);
+    for (int i = 0; i < 3; ++i) {
+        dll_destroy(registered[i], NULL);
+    }
+    expect(dll_memory_usage_total(&lists_after).total_bytes, before.total_bytes);
+
+    // tracing: only the outermost calls are recorded, with their positions
+    dll_t* traced = dll_create();
+    dll_trace_enable();
+    expect(dll_trace_enabled(), true);
+    for (int i = 0; i < 4; ++i) {
+        dll_append(traced, &nums[i]);
+    }
+    dll_swap(traced, 0, 3);
+    dll_t* traced_clone = dll_clone(traced);
+    dll_trace_disable();
+    dll_append(traced, &nums[4]);
+
+    FILE* json = tmpfile();
+    expect(dll_trace_dump(json), true);
+    rewind(json);
+    char   trace[4096];
+    size_t trace_len = fread(trace, 1, sizeof trace - 1, json);
+    trace[trace_len] = '\0';
+    fclose(json);
+    expect(strncmp(trace, "{\"traceEvents\":[", 16), 0);
+    expect((strstr(trace, "\"name\":\"dll_swap\"") != NULL), true);
+    expect((strstr(trace, "\"index1\":0,\"index2\":3}") != NULL), true);
+    expect((strstr(trace, "\"name\":\"dll_clone\"") != NULL), true);
+    // 4 appends, a swap and a clone: the appends done by the clone are part of it
+    size_t events = 0;
+    for (const char* at = trace; (at = strstr(at, "\"ph\":\"X\"")); ++at) {
+        events++;
+    }
+    expect(events, 6);
+    dll_trace_clear();
+    expect(trace_events(), 0);
+
+    // Threads coming and going reuse the rings of finished threads: only the last few threads' events remain
+    dll_trace_enable();
+    for (int i = 0; i < 3 * DLL_TRACE_KEPT_RINGS; ++i) {
+        pthread_t worker;
+        pthread_create(&worker, NULL, trace_worker, &nums[0]);
+        pthread_join(worker, NULL);
+    }
+    dll_trace_disable();
+    expect(trace_events(), DLL_TRACE_KEPT_RINGS * 2); // An append and a destroy each
+    dll_trace_clear();
+    dll_destroy(traced_clone, NULL);
+    dll_destroy(traced, NULL);
+
     return 0;
 }